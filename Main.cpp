@@ -7,300 +7,5906 @@
 #include <queue>
 #include <list>
 #include <limits>
+#include <numeric>
 #include <utility>
+#include <tuple>
+#include <cstdint>
+#include <cmath>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <unordered_map>
+#include <variant>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <chrono>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
 
 using namespace std;
 
-// Class representing a social network as an adjacency list graph
-class SocialNetwork {
-private:
-    map<string, set<string>> adj; // Adjacency list representation of the graph using sets for friends
+// Closed range of friendship timestamps; the default covers all time
+struct TimeWindow {
+    int64_t from = numeric_limits<int64_t>::min();
+    int64_t to = numeric_limits<int64_t>::max();
+
+    bool unbounded() const { return from == numeric_limits<int64_t>::min() && to == numeric_limits<int64_t>::max(); }
+    bool contains(int64_t t) const { return from <= t && t <= to; }
+};
+
+// Compressed sparse row (CSR) snapshot of the friendship graph over integer vertex IDs
+struct CSRGraph {
+    vector<uint64_t> offsets;   // Neighbors of v live in neighbors[offsets[v] .. offsets[v + 1])
+    vector<uint32_t> neighbors; // Concatenated neighbor lists, each sorted ascending
+    vector<float> weights;      // Optional per-arc weights aligned with neighbors (empty when unweighted)
+    vector<int64_t> times;      // Optional per-arc friendship timestamps aligned with neighbors (empty when untimed)
+
+    // Time index (built with times): each row's neighbors again, ordered by timestamp, and the timestamps
+    // in that order, so a window is two binary searches and a contiguous scan
+    vector<uint32_t> timeOrdered;
+    vector<int64_t> timeOrderedTimes;
+
+    uint32_t numVertices() const { return offsets.empty() ? 0 : static_cast<uint32_t>(offsets.size() - 1); }
+    uint64_t numArcs() const { return neighbors.size(); } // Each friendship is stored as two arcs
+    uint32_t degree(uint32_t v) const { return static_cast<uint32_t>(offsets[v + 1] - offsets[v]); }
+    const uint32_t *begin(uint32_t v) const { return neighbors.data() + offsets[v]; }
+    const uint32_t *end(uint32_t v) const { return neighbors.data() + offsets[v + 1]; }
+
+    // Neighbors of v whose friendship timestamp is inside window (all arcs count as time 0 when untimed)
+    pair<const uint32_t *, const uint32_t *> neighborsInWindow(uint32_t v, const TimeWindow &window) const {
+        if (window.unbounded()) return {begin(v), end(v)}; // Sorted by ID, like every plain row
+        if (timeOrdered.empty()) {
+            return window.contains(0) ? make_pair(begin(v), end(v)) : make_pair(end(v), end(v));
+        }
+        const int64_t *rowBegin = timeOrderedTimes.data() + offsets[v], *rowEnd = timeOrderedTimes.data() + offsets[v + 1];
+        const int64_t *first = std::lower_bound(rowBegin, rowEnd, window.from);
+        const int64_t *last = std::upper_bound(first, rowEnd, window.to);
+        return {timeOrdered.data() + (first - timeOrderedTimes.data()), timeOrdered.data() + (last - timeOrderedTimes.data())};
+    }
+};
+
+
+// Number of worker threads used by the parallel graph kernels
+inline unsigned workerCount() {
+    unsigned n = thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+// Runs body(begin, end, worker) over [0, count) in chunks of `grain` items handed out dynamically,
+// so threads that draw cheap (low-degree) chunks keep pulling work while hubs are processed
+template <typename Body>
+void parallelFor(size_t count, size_t grain, Body body) {
+    unsigned threads = workerCount();
+    if (threads == 1 || count <= grain) {
+        body(size_t(0), count, 0u);
+        return;
+    }
+    atomic<size_t> next(0);
+    auto worker = [&](unsigned id) {
+        for (size_t begin = next.fetch_add(grain); begin < count; begin = next.fetch_add(grain)) {
+            body(begin, min(count, begin + grain), id);
+        }
+    };
+    vector<thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker, t);
+    worker(0);
+    for (thread &th : pool) th.join();
+}
+
+// Builds the CSR time index from g.times: every row sorted by (timestamp, neighbor)
+void buildTimeIndex(CSRGraph &g) {
+    g.timeOrdered.resize(g.numArcs());
+    g.timeOrderedTimes.resize(g.numArcs());
+    parallelFor(g.numVertices(), 1024, [&g](size_t begin, size_t end, unsigned) {
+        vector<pair<int64_t, uint32_t>> row;
+        for (size_t v = begin; v < end; ++v) {
+            row.clear();
+            for (uint64_t arc = g.offsets[v]; arc < g.offsets[v + 1]; ++arc) row.emplace_back(g.times[arc], g.neighbors[arc]);
+            std::sort(row.begin(), row.end());
+            for (size_t i = 0; i < row.size(); ++i) {
+                g.timeOrderedTimes[g.offsets[v] + i] = row[i].first;
+                g.timeOrdered[g.offsets[v] + i] = row[i].second;
+            }
+        }
+    });
+}
+
+// Global PageRank via pull-based SpMV: each vertex gathers rank/degree from its neighbors.
+// Iterates until the L1 change between iterations drops below `tolerance`.
+vector<double> computePageRank(const CSRGraph &g, double damping, double tolerance, int maxIterations) {
+    const uint32_t n = g.numVertices();
+    vector<double> rank(n, n ? 1.0 / n : 0.0), next(n), contrib(n);
+    if (n == 0) return rank;
+
+    const unsigned threads = workerCount();
+    vector<double> partialDangling(threads), partialDelta(threads);
+    for (int iter = 0; iter < maxIterations; ++iter) {
+        // Scatter-free precomputation of each vertex's outgoing share; isolated users leak rank uniformly
+        fill(partialDangling.begin(), partialDangling.end(), 0.0);
+        parallelFor(n, 4096, [&](size_t begin, size_t end, unsigned worker) {
+            double dangling = 0.0;
+            for (size_t v = begin; v < end; ++v) {
+                uint32_t deg = g.degree(static_cast<uint32_t>(v));
+                if (deg == 0) {
+                    dangling += rank[v];
+                    contrib[v] = 0.0;
+                } else {
+                    contrib[v] = rank[v] / deg;
+                }
+            }
+            partialDangling[worker] += dangling;
+        });
+        double dangling = 0.0;
+        for (double d : partialDangling) dangling += d;
+        const double base = (1.0 - damping) / n + damping * dangling / n;
+
+        // Pull step: each vertex owns its output slot, so no atomics are needed
+        fill(partialDelta.begin(), partialDelta.end(), 0.0);
+        parallelFor(n, 1024, [&](size_t begin, size_t end, unsigned worker) {
+            double delta = 0.0;
+            for (size_t v = begin; v < end; ++v) {
+                double sum = 0.0;
+                for (const uint32_t *u = g.begin(static_cast<uint32_t>(v)); u != g.end(static_cast<uint32_t>(v)); ++u) {
+                    sum += contrib[*u];
+                }
+                next[v] = base + damping * sum;
+                delta += fabs(next[v] - rank[v]);
+            }
+            partialDelta[worker] += delta;
+        });
+        rank.swap(next);
+
+        double delta = 0.0;
+        for (double d : partialDelta) delta += d;
+        if (delta < tolerance) break;
+    }
+    return rank;
+}
+
+// Approximate personalized PageRank from `source` using forward push (Andersen-Chung-Lang).
+// Residual mass is pushed only while it exceeds epsilon * degree, so the work stays within
+// the source's local neighborhood instead of touching the whole graph.
+unordered_map<uint32_t, double> computePersonalizedPageRank(const CSRGraph &g, uint32_t source,
+                                                            double damping, double epsilon) {
+    unordered_map<uint32_t, double> estimate, residual;
+    residual[source] = 1.0;
+    vector<uint32_t> active{source};
+
+    while (!active.empty()) {
+        uint32_t u = active.back();
+        active.pop_back();
+        double r = residual[u];
+        uint32_t deg = g.degree(u);
+        if (deg == 0) {
+            // Isolated user: all residual mass stays at the user
+            estimate[u] += r;
+            residual[u] = 0.0;
+            continue;
+        }
+        if (r < epsilon * deg) continue;
+
+        estimate[u] += (1.0 - damping) * r;
+        residual[u] = 0.0;
+        double share = damping * r / deg;
+        for (const uint32_t *v = g.begin(u); v != g.end(u); ++v) {
+            double &rv = residual[*v];
+            double before = rv;
+            rv += share;
+            // Enqueue only when the residual crosses the push threshold, to avoid duplicates
+            uint32_t dv = g.degree(*v);
+            if (before < epsilon * dv && rv >= epsilon * dv) active.push_back(*v);
+        }
+    }
+    return estimate;
+}
+
+// Small, fast xoshiro128** generator; each worker thread owns one so sampling never contends
+struct FastRng {
+    uint32_t s[4];
+
+    explicit FastRng(uint64_t seed) {
+        // Expand the seed with splitmix64 so nearby seeds give unrelated streams
+        for (int i = 0; i < 4; i += 2) {
+            seed += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            z ^= z >> 31;
+            s[i] = static_cast<uint32_t>(z);
+            s[i + 1] = static_cast<uint32_t>(z >> 32);
+        }
+    }
+
+    uint32_t next() {
+        uint32_t x = s[1] * 5;
+        uint32_t result = ((x << 7) | (x >> 25)) * 9;
+        uint32_t t = s[1] << 9;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = (s[3] << 11) | (s[3] >> 21);
+        return result;
+    }
+
+    // Uniform integer in [0, bound) via multiply-shift (no division)
+    uint32_t below(uint32_t bound) { return static_cast<uint32_t>((static_cast<uint64_t>(next()) * bound) >> 32); }
+
+    // Uniform double in [0, 1)
+    double uniform() { return (next() >> 8) * (1.0 / 16777216.0); }
+};
+
+// Per-vertex Walker alias tables for O(1) weighted neighbor sampling, aligned with CSRGraph::neighbors
+struct AliasTables {
+    vector<float> probability; // Chance of keeping the slot's own neighbor
+    vector<uint32_t> alias;    // Otherwise take this local neighbor index instead
+
+    // Samples a neighbor of v (v must have at least one neighbor)
+    uint32_t sample(const CSRGraph &g, uint32_t v, FastRng &rng) const {
+        uint32_t slot = rng.below(g.degree(v));
+        uint64_t arc = g.offsets[v] + slot;
+        if (rng.uniform() >= probability[arc]) arc = g.offsets[v] + alias[arc];
+        return g.neighbors[arc];
+    }
+};
+
+// Builds alias tables for every vertex with Vose's method (uniform tables when the graph is unweighted)
+AliasTables buildAliasTables(const CSRGraph &g) {
+    AliasTables tables;
+    tables.probability.assign(g.numArcs(), 1.0f);
+    tables.alias.assign(g.numArcs(), 0);
+    if (g.weights.empty()) return tables;
+
+    parallelFor(g.numVertices(), 256, [&](size_t begin, size_t end, unsigned) {
+        vector<double> scaled;
+        vector<uint32_t> small, large;
+        for (size_t v = begin; v < end; ++v) {
+            uint32_t deg = g.degree(static_cast<uint32_t>(v));
+            if (deg == 0) continue;
+            uint64_t base = g.offsets[v];
+            double total = 0.0;
+            for (uint32_t i = 0; i < deg; ++i) total += g.weights[base + i];
+
+            scaled.assign(deg, 1.0);
+            small.clear();
+            large.clear();
+            for (uint32_t i = 0; i < deg; ++i) {
+                if (total > 0.0) scaled[i] = g.weights[base + i] * deg / total;
+                (scaled[i] < 1.0 ? small : large).push_back(i);
+            }
+            while (!small.empty() && !large.empty()) {
+                uint32_t s = small.back(), l = large.back();
+                small.pop_back();
+                tables.probability[base + s] = static_cast<float>(scaled[s]);
+                tables.alias[base + s] = l;
+                scaled[l] -= 1.0 - scaled[s];
+                if (scaled[l] < 1.0) {
+                    large.pop_back();
+                    small.push_back(l);
+                }
+            }
+            // Leftovers are full slots (up to floating-point rounding)
+            for (uint32_t i : small) tables.probability[base + i] = 1.0f;
+            for (uint32_t i : large) tables.probability[base + i] = 1.0f;
+        }
+    });
+    return tables;
+}
+
+// Monte Carlo random walk with restart from `source`. A fixed budget of walk steps is split across
+// worker threads; each thread counts the vertices its walks visit. Cost is bounded by the budget,
+// independent of how large the source's 2-hop neighborhood is.
+unordered_map<uint32_t, uint32_t> sampleRandomWalkVisits(const CSRGraph &g, const AliasTables &tables,
+                                                         uint32_t source, size_t walkBudget,
+                                                         double restartProbability) {
+    unordered_map<uint32_t, uint32_t> visits;
+    if (g.degree(source) == 0 || walkBudget == 0) return visits;
+
+    const unsigned threads = static_cast<unsigned>(min<size_t>(workerCount(), (walkBudget + 1023) / 1024));
+    vector<unordered_map<uint32_t, uint32_t>> localVisits(threads);
+    const uint32_t restartThreshold = static_cast<uint32_t>(min(max(restartProbability, 0.0), 1.0) * 4294967295.0);
+    auto worker = [&](unsigned id) {
+        FastRng rng(source * 0x100000001B3ULL + id);
+        unordered_map<uint32_t, uint32_t> &counts = localVisits[id];
+        size_t steps = walkBudget / threads + (id < walkBudget % threads ? 1 : 0);
+        uint32_t current = source;
+        for (size_t step = 0; step < steps; ++step) {
+            current = tables.sample(g, current, rng);
+            if (current != source) ++counts[current];
+            // Restart at the source with the given probability, or when stuck at a dead end
+            if (rng.next() < restartThreshold || g.degree(current) == 0) current = source;
+        }
+    };
+    vector<thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker, t);
+    worker(0);
+    for (thread &th : pool) th.join();
+
+    visits.swap(localVisits[0]);
+    for (unsigned t = 1; t < threads; ++t) {
+        for (const auto &entry : localVisits[t]) visits[entry.first] += entry.second;
+    }
+    return visits;
+}
+
+// Brandes' betweenness centrality accumulated from the given BFS sources. Sources are processed in
+// parallel; every worker owns its BFS workspace and a private dependency accumulator, and the
+// accumulators are summed once at the end. Scores count each unordered pair once.
+vector<double> computeBetweenness(const CSRGraph &g, const vector<uint32_t> &sources) {
+    const uint32_t n = g.numVertices();
+    const unsigned threads = workerCount();
+    vector<vector<double>> partial(threads);
+
+    parallelFor(sources.size(), 1, [&](size_t begin, size_t end, unsigned worker) {
+        vector<double> &centrality = partial[worker];
+        if (centrality.empty()) centrality.assign(n, 0.0);
+        vector<int32_t> dist(n, -1);
+        vector<double> sigma(n, 0.0), delta(n, 0.0);
+        vector<uint32_t> order; // Vertices in non-decreasing distance; doubles as the BFS queue
+        order.reserve(n);
+
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t s = sources[i];
+            order.clear();
+            order.push_back(s);
+            dist[s] = 0;
+            sigma[s] = 1.0;
+            for (size_t head = 0; head < order.size(); ++head) {
+                uint32_t u = order[head];
+                for (const uint32_t *v = g.begin(u); v != g.end(u); ++v) {
+                    if (dist[*v] < 0) {
+                        dist[*v] = dist[u] + 1;
+                        order.push_back(*v);
+                    }
+                    if (dist[*v] == dist[u] + 1) sigma[*v] += sigma[u];
+                }
+            }
+            // Back-propagate dependencies in reverse BFS order; predecessors are found by distance
+            for (size_t j = order.size(); j-- > 1;) {
+                uint32_t w = order[j];
+                double coefficient = (1.0 + delta[w]) / sigma[w];
+                for (const uint32_t *v = g.begin(w); v != g.end(w); ++v) {
+                    if (dist[*v] == dist[w] - 1) delta[*v] += sigma[*v] * coefficient;
+                }
+                centrality[w] += delta[w];
+            }
+            // Reset only what this source touched
+            for (uint32_t v : order) {
+                dist[v] = -1;
+                sigma[v] = 0.0;
+                delta[v] = 0.0;
+            }
+        }
+    });
+
+    vector<double> total(n, 0.0);
+    for (const vector<double> &centrality : partial) {
+        if (centrality.empty()) continue;
+        for (uint32_t v = 0; v < n; ++v) total[v] += centrality[v];
+    }
+    for (double &score : total) score /= 2.0; // Each unordered pair was counted from both ends
+    return total;
+}
+
+// Chooses `count` distinct pivot vertices uniformly at random
+vector<uint32_t> samplePivots(uint32_t n, size_t count, uint64_t seed) {
+    vector<uint32_t> vertices(n);
+    for (uint32_t v = 0; v < n; ++v) vertices[v] = v;
+    count = min<size_t>(count, n);
+    FastRng rng(seed);
+    // Partial Fisher-Yates shuffle
+    for (size_t i = 0; i < count; ++i) {
+        swap(vertices[i], vertices[i + rng.below(static_cast<uint32_t>(n - i))]);
+    }
+    vertices.resize(count);
+    return vertices;
+}
+
+// Additive error bound on sampled betweenness (in the same units as the scores) that holds for all
+// vertices simultaneously with probability `confidence`: each pivot contributes a dependency in
+// [0, n - 2], so Hoeffding's inequality plus a union bound over n vertices applies.
+double betweennessErrorBound(uint32_t n, size_t pivots, double confidence) {
+    if (pivots == 0 || n < 3) return 0.0;
+    double failure = 1.0 - confidence;
+    double normalized = sqrt(log(2.0 * n / failure) / (2.0 * pivots));
+    return normalized * (n - 2) * n / 2.0;
+}
+
+// Result of a HyperANF run over the CSR snapshot
+struct HyperAnfResult {
+    vector<double> neighborhoodFunction; // N(t): estimated number of pairs (u, v) with dist(u, v) <= t
+    vector<double> reach;                // Per-vertex estimate of users within the last computed hop count
+};
+
+// Register-wise max of two HyperLogLog counters: dst[i] = max(dst[i], src[i]). Returns true if dst changed.
+inline bool hyperLogLogUnion(uint8_t *dst, const uint8_t *src, size_t registers) {
+    bool changed = false;
+    size_t i = 0;
+#ifdef __SSE2__
+    for (; i + 16 <= registers; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i merged = _mm_max_epu8(a, b);
+        changed |= _mm_movemask_epi8(_mm_cmpeq_epi8(merged, a)) != 0xFFFF;
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), merged);
+    }
+#endif
+    for (; i < registers; ++i) {
+        if (src[i] > dst[i]) {
+            dst[i] = src[i];
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+// HyperLogLog cardinality estimate with the small-range (linear counting) correction
+double hyperLogLogEstimate(const uint8_t *counter, size_t registers) {
+    double inverseSum = 0.0;
+    size_t zeros = 0;
+    for (size_t i = 0; i < registers; ++i) {
+        inverseSum += ldexp(1.0, -counter[i]);
+        if (counter[i] == 0) ++zeros;
+    }
+    const double m = static_cast<double>(registers);
+    const double alpha = registers == 16 ? 0.673 : registers == 32 ? 0.697 : registers == 64 ? 0.709 : 0.7213 / (1.0 + 1.079 / m);
+    double estimate = alpha * m * m / inverseSum;
+    if (estimate <= 2.5 * m && zeros > 0) estimate = m * log(m / zeros);
+    return estimate;
+}
+
+// HyperANF: every vertex keeps a HyperLogLog counter of the users it can reach. Pass t unions each
+// counter with its neighbors' counters from pass t - 1, so after t passes a counter sketches the
+// t-hop ball. Stops after maxHops passes or once no counter changes (t exceeded the diameter).
+HyperAnfResult computeHyperAnf(const CSRGraph &g, int maxHops, int log2Registers) {
+    log2Registers = min(max(log2Registers, 4), 16);
+    const uint32_t n = g.numVertices();
+    const size_t m = size_t(1) << log2Registers;
+    vector<uint8_t> current(n * m, 0), next;
+    HyperAnfResult result;
+
+    // Seed each counter with its own vertex
+    for (uint32_t v = 0; v < n; ++v) {
+        uint64_t h = (v + 1) * 0x9E3779B97F4A7C15ULL;
+        h = (h ^ (h >> 31)) * 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 29;
+        size_t index = h >> (64 - log2Registers);
+        uint64_t rest = (h << log2Registers) | (uint64_t(1) << (log2Registers - 1)); // Guard bit bounds rho
+        current[v * m + index] = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+    }
+
+    const unsigned threads = workerCount();
+    vector<double> partialSum(threads);
+    auto sumEstimates = [&](const vector<uint8_t> &counters) {
+        fill(partialSum.begin(), partialSum.end(), 0.0);
+        result.reach.resize(n);
+        parallelFor(n, 1024, [&](size_t begin, size_t end, unsigned worker) {
+            double sum = 0.0;
+            for (size_t v = begin; v < end; ++v) {
+                result.reach[v] = hyperLogLogEstimate(counters.data() + v * m, m);
+                sum += result.reach[v];
+            }
+            partialSum[worker] += sum;
+        });
+        double total = 0.0;
+        for (double p : partialSum) total += p;
+        return total;
+    };
+    result.neighborhoodFunction.push_back(sumEstimates(current));
+
+    vector<char> partialChanged(threads);
+    for (int t = 1; t <= maxHops; ++t) {
+        next = current;
+        fill(partialChanged.begin(), partialChanged.end(), 0);
+        parallelFor(n, 256, [&](size_t begin, size_t end, unsigned worker) {
+            bool changed = false;
+            for (size_t v = begin; v < end; ++v) {
+                uint8_t *dst = next.data() + v * m;
+                for (const uint32_t *u = g.begin(static_cast<uint32_t>(v)); u != g.end(static_cast<uint32_t>(v)); ++u) {
+                    changed |= hyperLogLogUnion(dst, current.data() + size_t(*u) * m, m);
+                }
+            }
+            if (changed) partialChanged[worker] = 1;
+        });
+        if (find(partialChanged.begin(), partialChanged.end(), 1) == partialChanged.end()) break;
+        current.swap(next);
+        result.neighborhoodFunction.push_back(sumEstimates(current));
+    }
+    return result;
+}
+
+// Effective diameter: the (interpolated) hop count within which `quantile` of all reachable pairs fall
+double effectiveDiameter(const vector<double> &neighborhoodFunction, double quantile) {
+    if (neighborhoodFunction.empty()) return 0.0;
+    double target = quantile * neighborhoodFunction.back();
+    for (size_t t = 0; t < neighborhoodFunction.size(); ++t) {
+        if (neighborhoodFunction[t] >= target) {
+            if (t == 0) return 0.0;
+            double below = neighborhoodFunction[t - 1];
+            return (t - 1) + (target - below) / (neighborhoodFunction[t] - below);
+        }
+    }
+    return static_cast<double>(neighborhoodFunction.size() - 1);
+}
+
+// Subgraph extracted from a CSR snapshot, renumbered to dense local IDs
+struct CSRSubgraph {
+    CSRGraph graph;
+    vector<uint32_t> vertexIds; // Local ID -> vertex ID in the parent snapshot (ascending)
+};
+
+// Builds the subgraph induced by `vertices` (sorted ascending, no duplicates)
+CSRSubgraph inducedSubgraph(const CSRGraph &g, const vector<uint32_t> &vertices) {
+    CSRSubgraph sub;
+    sub.vertexIds = vertices;
+    unordered_map<uint32_t, uint32_t> localId;
+    localId.reserve(vertices.size());
+    for (uint32_t i = 0; i < vertices.size(); ++i) localId[vertices[i]] = i;
+
+    sub.graph.offsets.assign(vertices.size() + 1, 0);
+    for (uint32_t i = 0; i < vertices.size(); ++i) {
+        uint32_t v = vertices[i];
+        for (uint64_t arc = g.offsets[v]; arc < g.offsets[v + 1]; ++arc) {
+            auto it = localId.find(g.neighbors[arc]);
+            if (it == localId.end()) continue;
+            // Global neighbor order is ascending and the renumbering is monotone, so rows stay sorted
+            sub.graph.neighbors.push_back(it->second);
+            if (!g.weights.empty()) sub.graph.weights.push_back(g.weights[arc]);
+        }
+        sub.graph.offsets[i + 1] = sub.graph.neighbors.size();
+    }
+    return sub;
+}
+
+// Linear-time k-core decomposition (Batagelj-Zaversnik): vertices are bucket-sorted by degree and
+// peeled in order of current degree, moving each affected neighbor down one bucket in O(1)
+vector<uint32_t> computeCoreNumbers(const CSRGraph &g) {
+    const uint32_t n = g.numVertices();
+    vector<uint32_t> degree(n), position(n), order(n);
+    uint32_t maxDegree = 0;
+    for (uint32_t v = 0; v < n; ++v) {
+        degree[v] = g.degree(v);
+        maxDegree = max(maxDegree, degree[v]);
+    }
+
+    // bucketStart[d] = first slot in `order` holding a vertex of current degree d
+    vector<uint32_t> bucketStart(maxDegree + 2, 0);
+    for (uint32_t v = 0; v < n; ++v) ++bucketStart[degree[v] + 1];
+    for (uint32_t d = 1; d <= maxDegree + 1; ++d) bucketStart[d] += bucketStart[d - 1];
+    {
+        vector<uint32_t> fill(bucketStart.begin(), bucketStart.end() - 1);
+        for (uint32_t v = 0; v < n; ++v) {
+            position[v] = fill[degree[v]]++;
+            order[position[v]] = v;
+        }
+    }
+
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t v = order[i];
+        for (const uint32_t *u = g.begin(v); u != g.end(v); ++u) {
+            if (degree[*u] <= degree[v]) continue;
+            // Swap u with the first vertex of its bucket, then shrink the bucket from the front
+            uint32_t du = degree[*u];
+            uint32_t first = order[bucketStart[du]];
+            if (first != *u) {
+                swap(order[position[*u]], order[bucketStart[du]]);
+                swap(position[*u], position[first]);
+            }
+            ++bucketStart[du];
+            --degree[*u];
+        }
+    }
+    return degree; // After peeling, each vertex's remaining degree is its core number
+}
+
+// Parallel k-core decomposition by level-synchronous peeling: for k = 0, 1, ... all vertices of
+// degree <= k are removed together, and their neighbors' degrees are decremented atomically. A
+// neighbor whose degree drops to exactly k joins the next sub-round of the same level.
+vector<uint32_t> computeCoreNumbersParallel(const CSRGraph &g) {
+    const uint32_t n = g.numVertices();
+    const uint32_t unassigned = numeric_limits<uint32_t>::max();
+    vector<atomic<uint32_t>> degree(n), core(n);
+    for (uint32_t v = 0; v < n; ++v) {
+        degree[v].store(g.degree(v), memory_order_relaxed);
+        core[v].store(unassigned, memory_order_relaxed);
+    }
+
+    const unsigned threads = workerCount();
+    vector<vector<uint32_t>> localFrontier(threads);
+    vector<uint32_t> partialMin(threads);
+    vector<uint32_t> frontier;
+    uint32_t remaining = n;
+    uint32_t k = 0;
+    while (remaining > 0) {
+        // Collect the initial frontier for level k
+        parallelFor(n, 4096, [&](size_t begin, size_t end, unsigned worker) {
+            for (size_t v = begin; v < end; ++v) {
+                if (core[v].load(memory_order_relaxed) != unassigned) continue;
+                if (degree[v].load(memory_order_relaxed) <= k) {
+                    core[v].store(k, memory_order_relaxed);
+                    localFrontier[worker].push_back(static_cast<uint32_t>(v));
+                }
+            }
+        });
+
+        for (;;) {
+            frontier.clear();
+            for (vector<uint32_t> &local : localFrontier) {
+                frontier.insert(frontier.end(), local.begin(), local.end());
+                local.clear();
+            }
+            if (frontier.empty()) break;
+            remaining -= static_cast<uint32_t>(frontier.size());
+
+            parallelFor(frontier.size(), 64, [&](size_t begin, size_t end, unsigned worker) {
+                for (size_t i = begin; i < end; ++i) {
+                    uint32_t v = frontier[i];
+                    for (const uint32_t *u = g.begin(v); u != g.end(v); ++u) {
+                        if (core[*u].load(memory_order_relaxed) != unassigned) continue;
+                        // fetch_sub hands out each old value once, so exactly one thread claims u
+                        if (degree[*u].fetch_sub(1, memory_order_relaxed) == k + 1) {
+                            core[*u].store(k, memory_order_relaxed);
+                            localFrontier[worker].push_back(*u);
+                        }
+                    }
+                }
+            });
+        }
+
+        if (remaining == 0) break;
+
+        // Skip empty levels straight to the smallest degree left. It is read only now, after this
+        // level's peeling: degrees taken before it could overshoot vertices it lowered.
+        fill(partialMin.begin(), partialMin.end(), unassigned);
+        parallelFor(n, 4096, [&](size_t begin, size_t end, unsigned worker) {
+            for (size_t v = begin; v < end; ++v) {
+                if (core[v].load(memory_order_relaxed) != unassigned) continue;
+                partialMin[worker] = min(partialMin[worker], degree[v].load(memory_order_relaxed));
+            }
+        });
+        k = max(k + 1, *min_element(partialMin.begin(), partialMin.end()));
+    }
+
+    vector<uint32_t> result(n);
+    for (uint32_t v = 0; v < n; ++v) result[v] = core[v].load(memory_order_relaxed);
+    return result;
+}
+
+// Result of a parallel BFS: the BFS tree and the number of vertices first reached at each hop
+struct BFSTree {
+    static constexpr uint32_t kUnreached = numeric_limits<uint32_t>::max();
+    vector<uint32_t> parent;     // kUnreached when not reached; the source is its own parent
+    vector<uint32_t> depth;      // Hops from the source, kUnreached when not reached
+    vector<uint32_t> levelSizes; // levelSizes[h]: vertices at exactly h hops
+};
+
+// Level-synchronous parallel BFS. Each level's frontier is cut into chunks of about kBFSChunkArcs
+// arcs (not vertices), so a hub's row is split across chunks; parallelFor hands the chunks out
+// dynamically, letting idle threads take over the rest of a skewed level. A vertex is claimed by
+// CAS on its parent, and each worker appends its claims to its own next-frontier buffer; the
+// buffers are concatenated at prefix-sum offsets. With a target, stops after the level reaching it.
+constexpr uint64_t kBFSChunkArcs = 2048;
+constexpr uint64_t kParallelBFSMinArcs = uint64_t(1) << 20; // Smaller graphs stay on one thread
+
+BFSTree computeParallelBFS(const CSRGraph &g, uint32_t source, uint32_t target = BFSTree::kUnreached) {
+    const uint32_t n = g.numVertices();
+    BFSTree tree;
+    vector<atomic<uint32_t>> parent(n);
+    for (uint32_t v = 0; v < n; ++v) parent[v].store(BFSTree::kUnreached, memory_order_relaxed);
+    tree.depth.assign(n, BFSTree::kUnreached);
+    parent[source].store(source, memory_order_relaxed);
+    tree.depth[source] = 0;
+
+    const unsigned threads = workerCount();
+    vector<vector<uint32_t>> localNext(threads);
+    vector<uint32_t> frontier{source}, next;
+    vector<uint64_t> arcStart; // arcStart[i]: arcs of frontier[0, i)
+    vector<size_t> offsets(threads + 1);
+    for (uint32_t level = 0; !frontier.empty(); ++level) {
+        tree.levelSizes.push_back(static_cast<uint32_t>(frontier.size()));
+        if (target != BFSTree::kUnreached && tree.depth[target] != BFSTree::kUnreached) break;
+
+        arcStart.resize(frontier.size() + 1);
+        arcStart[0] = 0;
+        for (size_t i = 0; i < frontier.size(); ++i) arcStart[i + 1] = arcStart[i] + g.degree(frontier[i]);
+        const uint64_t arcs = arcStart.back();
+        const size_t chunks = static_cast<size_t>((arcs + kBFSChunkArcs - 1) / kBFSChunkArcs);
+
+        parallelFor(chunks, 1, [&](size_t begin, size_t end, unsigned worker) {
+            const uint64_t first = begin * kBFSChunkArcs, last = min<uint64_t>(arcs, end * kBFSChunkArcs);
+            // The frontier vertex whose row contains arc `first`
+            size_t i = std::upper_bound(arcStart.begin(), arcStart.end(), first) - arcStart.begin() - 1;
+            for (uint64_t arc = first; arc < last; ++i) {
+                const uint32_t u = frontier[i];
+                const uint32_t *row = g.begin(u);
+                const uint64_t rowEnd = min(arcStart[i + 1], last);
+                for (; arc < rowEnd; ++arc) {
+                    const uint32_t v = row[arc - arcStart[i]];
+                    uint32_t expected = BFSTree::kUnreached;
+                    // Plain load first: most neighbors are already claimed, and a failed CAS still
+                    // takes the cache line exclusively
+                    if (parent[v].load(memory_order_relaxed) != expected) continue;
+                    if (parent[v].compare_exchange_strong(expected, u, memory_order_relaxed)) {
+                        tree.depth[v] = level + 1;
+                        localNext[worker].push_back(v);
+                    }
+                }
+            }
+        });
+
+        offsets[0] = 0;
+        for (unsigned t = 0; t < threads; ++t) offsets[t + 1] = offsets[t] + localNext[t].size();
+        next.resize(offsets[threads]);
+        parallelFor(threads, 1, [&](size_t begin, size_t end, unsigned) {
+            for (size_t t = begin; t < end; ++t) {
+                std::copy(localNext[t].begin(), localNext[t].end(), next.begin() + offsets[t]);
+                localNext[t].clear();
+            }
+        });
+        frontier.swap(next);
+    }
+
+    tree.parent.resize(n);
+    for (uint32_t v = 0; v < n; ++v) tree.parent[v] = parent[v].load(memory_order_relaxed);
+    return tree;
+}
+
+// Shortest-path counts can exceed 64 bits in dense graphs, so they use 128-bit counters (a GCC/Clang
+// extension) that saturate instead of wrapping
+using PathCounter = unsigned __int128;
+constexpr PathCounter kPathCounterMax = ~PathCounter(0);
+
+inline PathCounter saturatingAdd(PathCounter a, PathCounter b) { return a > kPathCounterMax - b ? kPathCounterMax : a + b; }
+inline PathCounter saturatingMultiply(PathCounter a, PathCounter b) {
+    return a != 0 && b > kPathCounterMax / a ? kPathCounterMax : a * b;
+}
 
+// Scratch for repeated bidirectional BFS searches over one snapshot, kept between queries. Visit
+// marks are epoch stamps, so starting a search is O(1) instead of clearing per-vertex arrays.
+// Between reset() and search(), vertices can be blocked (never entered) and friendships out of the
+// source cut, which is what Yen's spur searches need.
+class PathSearchWorkspace {
 public:
-    void addUser(const string &userName);
-    void addFriendship(const string &user1, const string &user2);
-    set<string> getFriends(const string &userName) const;
-    void printGraph() const;
+    // Starts a new search over a graph with n vertices
+    void reset(uint32_t n) {
+        if (blockedAt.size() != n || ++epoch == 0) {
+            blockedAt.assign(n, 0);
+            cutAt.assign(n, 0);
+            for (int side = 0; side < 2; ++side) {
+                seen[side].assign(n, 0);
+                parent[side].resize(n);
+                depth[side].resize(n);
+            }
+            epoch = 1;
+        }
+    }
 
-    // Advanced graph operations
-    set<string> getMutualFriends(const string &user1, const string &user2);
-    vector<pair<string, int>> suggestFriends(const string &userName);
-    pair<int, list<string>> shortestPathBFS(const string &startUser, const string &endUser);
-    pair<int, list<string>> shortestPathDijkstra(const string &startUser, const string &endUser);
+    void block(uint32_t v) { blockedAt[v] = epoch; }     // Exclude v from the search
+    void cutFromSource(uint32_t v) { cutAt[v] = epoch; } // Drop the friendship source - v
+
+    // Shortest path from source to target (inclusive) avoiding blocked vertices and cut friendships,
+    // growing the smaller of the two BFS frontiers one full level at a time. Returns false if none.
+    bool search(const CSRGraph &g, uint32_t source, uint32_t target, vector<uint32_t> &path) {
+        path.clear();
+        if (source == target) {
+            path.push_back(source);
+            return true;
+        }
+        const uint32_t ends[2] = {source, target};
+        for (int side = 0; side < 2; ++side) {
+            visit(side, ends[side], ends[side], 0);
+            frontier[side].assign(1, ends[side]);
+        }
+        uint32_t meet = kNone, best = numeric_limits<uint32_t>::max();
+        while (meet == kNone && !frontier[0].empty() && !frontier[1].empty()) {
+            const int side = frontier[0].size() <= frontier[1].size() ? 0 : 1;
+            next.clear();
+            for (uint32_t u : frontier[side]) {
+                for (const uint32_t *v = g.begin(u); v != g.end(u); ++v) {
+                    if (seen[side][*v] == epoch || blockedAt[*v] == epoch || cut(u, *v, source)) continue;
+                    visit(side, *v, u, depth[side][u] + 1);
+                    next.push_back(*v);
+                    // Finish the level, then keep the shortest connection found in it
+                    if (seen[1 - side][*v] == epoch && depth[0][*v] + depth[1][*v] < best) {
+                        best = depth[0][*v] + depth[1][*v];
+                        meet = *v;
+                    }
+                }
+            }
+            frontier[side].swap(next);
+        }
+        if (meet == kNone) return false;
+        for (uint32_t v = meet; v != source; v = parent[0][v]) path.push_back(v);
+        path.push_back(source);
+        std::reverse(path.begin(), path.end());
+        for (uint32_t v = meet; v != target; path.push_back(v = parent[1][v])) {}
+        return true;
+    }
+
+    // Counts the shortest paths from source to target, returning their length in hops (-1 if the
+    // users are not connected). Both BFS trees count paths per vertex as they grow, the smaller
+    // frontier first, and the search stops at the first level where they meet: every shortest path
+    // crosses that level once, so the total is the sum over the meeting vertices of forward count
+    // times backward count.
+    int countPaths(const CSRGraph &g, uint32_t source, uint32_t target, PathCounter &count) {
+        meets.clear();
+        count = 1;
+        if (source == target) return 0;
+        for (int side = 0; side < 2; ++side) paths[side].resize(seen[side].size());
+        const uint32_t ends[2] = {source, target};
+        for (int side = 0; side < 2; ++side) {
+            visit(side, ends[side], ends[side], 0);
+            paths[side][ends[side]] = 1;
+            frontier[side].assign(1, ends[side]);
+        }
+        count = 0;
+        while (meets.empty() && !frontier[0].empty() && !frontier[1].empty()) {
+            const int side = frontier[0].size() <= frontier[1].size() ? 0 : 1;
+            next.clear();
+            for (uint32_t u : frontier[side]) {
+                for (const uint32_t *v = g.begin(u); v != g.end(u); ++v) {
+                    if (seen[side][*v] != epoch) {
+                        visit(side, *v, u, depth[side][u] + 1);
+                        paths[side][*v] = paths[side][u];
+                        next.push_back(*v);
+                    } else if (depth[side][*v] == depth[side][u] + 1) {
+                        paths[side][*v] = saturatingAdd(paths[side][*v], paths[side][u]);
+                    }
+                }
+            }
+            // Counts on the new level are complete only now; keep the vertices closest to the other end
+            uint32_t closest = numeric_limits<uint32_t>::max();
+            for (uint32_t v : next) {
+                if (seen[1 - side][v] == epoch) closest = min(closest, depth[1 - side][v]);
+            }
+            for (uint32_t v : next) {
+                if (seen[1 - side][v] == epoch && depth[1 - side][v] == closest) {
+                    meets.push_back(v);
+                    count = saturatingAdd(count, saturatingMultiply(paths[0][v], paths[1][v]));
+                }
+            }
+            frontier[side].swap(next);
+        }
+        return meets.empty() ? -1 : static_cast<int>(depth[0][meets[0]] + depth[1][meets[0]]);
+    }
+
+    // Draws one of the shortest paths counted by the last countPaths, uniformly at random (up to
+    // floating-point rounding of huge counts): a meeting vertex is picked in proportion to the paths
+    // through it, and each step back toward an end picks a neighbor in proportion to its count.
+    void samplePath(const CSRGraph &g, uint32_t source, uint32_t target, FastRng &rng, vector<uint32_t> &path) {
+        path.clear();
+        if (source == target) {
+            path.push_back(source);
+            return;
+        }
+        vector<double> &weights = sampleWeights;
+        weights.clear();
+        for (uint32_t v : meets) weights.push_back(double(paths[0][v]) * double(paths[1][v]));
+        uint32_t v = meets[pickWeighted(weights, rng)];
+        vector<uint32_t> toTarget;
+        for (int side = 0; side < 2; ++side) {
+            vector<uint32_t> &half = side == 0 ? path : toTarget;
+            for (uint32_t at = v; depth[side][at] > 0;) {
+                candidates.clear();
+                weights.clear();
+                for (const uint32_t *u = g.begin(at); u != g.end(at); ++u) {
+                    if (seen[side][*u] == epoch && depth[side][*u] + 1 == depth[side][at]) {
+                        candidates.push_back(*u);
+                        weights.push_back(double(paths[side][*u]));
+                    }
+                }
+                at = candidates[pickWeighted(weights, rng)];
+                half.push_back(at);
+            }
+        }
+        std::reverse(path.begin(), path.end());
+        path.push_back(v);
+        path.insert(path.end(), toTarget.begin(), toTarget.end());
+    }
+
+private:
+    static constexpr uint32_t kNone = numeric_limits<uint32_t>::max();
+    uint32_t epoch = 0;
+    vector<uint32_t> blockedAt, cutAt; // Epoch in which a vertex was blocked / cut from the source
+    vector<uint32_t> seen[2], parent[2], depth[2];
+    vector<uint32_t> frontier[2], next;
+    vector<PathCounter> paths[2]; // Shortest paths from each end (countPaths only)
+    vector<uint32_t> meets;       // Meeting vertices of the last countPaths
+    vector<uint32_t> candidates;
+    vector<double> sampleWeights;
+
+    static size_t pickWeighted(const vector<double> &weights, FastRng &rng) {
+        double total = 0.0;
+        for (double w : weights) total += w;
+        double r = rng.uniform() * total;
+        for (size_t i = 0; i + 1 < weights.size(); ++i) {
+            if (r < weights[i]) return i;
+            r -= weights[i];
+        }
+        return weights.size() - 1;
+    }
+
+    bool cut(uint32_t u, uint32_t v, uint32_t source) const {
+        return (u == source && cutAt[v] == epoch) || (v == source && cutAt[u] == epoch);
+    }
+    void visit(int side, uint32_t v, uint32_t from, uint32_t hops) {
+        seen[side][v] = epoch;
+        parent[side][v] = from;
+        depth[side][v] = hops;
+    }
+};
+
+// Community detection output: a dense community ID per vertex and the resulting modularity
+struct CommunityAssignment {
+    vector<uint32_t> community;
+    uint32_t communityCount = 0;
+    double modularity = 0.0;
+};
+
+// Weight of the arc at position `arc` (1 when the graph is unweighted)
+inline double arcWeight(const CSRGraph &g, uint64_t arc) {
+    return g.weights.empty() ? 1.0 : g.weights[arc];
+}
+
+// Newman modularity of a partition: sum over communities of in_c / 2m - (tot_c / 2m)^2
+double computeModularity(const CSRGraph &g, const vector<uint32_t> &community) {
+    const uint32_t n = g.numVertices();
+    uint32_t count = 0;
+    for (uint32_t c : community) count = max(count, c + 1);
+    vector<double> total(count, 0.0);
+    double internal = 0.0, twoM = 0.0;
+    for (uint32_t v = 0; v < n; ++v) {
+        for (uint64_t arc = g.offsets[v]; arc < g.offsets[v + 1]; ++arc) {
+            double w = arcWeight(g, arc);
+            total[community[v]] += w;
+            twoM += w;
+            if (community[g.neighbors[arc]] == community[v]) internal += w;
+        }
+    }
+    if (twoM == 0.0) return 0.0;
+    double q = internal / twoM;
+    for (double t : total) q -= (t / twoM) * (t / twoM);
+    return q;
+}
+
+// Renumbers arbitrary labels to dense IDs 0..k-1 in order of first appearance; returns k
+uint32_t compactLabels(vector<uint32_t> &labels) {
+    unordered_map<uint32_t, uint32_t> dense;
+    for (uint32_t &label : labels) {
+        auto it = dense.emplace(label, static_cast<uint32_t>(dense.size())).first;
+        label = it->second;
+    }
+    return static_cast<uint32_t>(dense.size());
+}
+
+// Asynchronous label propagation: every vertex repeatedly adopts the label most frequent among its
+// neighbors (ties keep the current label, then prefer the smaller label). Threads update a shared label
+// array in place, so later vertices in a round already see earlier moves. Stops when fewer than
+// 0.1% of vertices change in a round or after maxRounds.
+CommunityAssignment computeLabelPropagation(const CSRGraph &g, int maxRounds) {
+    const uint32_t n = g.numVertices();
+    vector<atomic<uint32_t>> label(n);
+    for (uint32_t v = 0; v < n; ++v) label[v].store(v, memory_order_relaxed);
+
+    // Visit vertices in a fixed random order so label waves do not follow ID order
+    vector<uint32_t> order = samplePivots(n, n, 0x5EEDULL);
+    const unsigned threads = workerCount();
+    vector<uint64_t> partialChanged(threads);
+    for (int round = 0; round < maxRounds; ++round) {
+        fill(partialChanged.begin(), partialChanged.end(), 0);
+        parallelFor(n, 1024, [&](size_t begin, size_t end, unsigned worker) {
+            unordered_map<uint32_t, double> frequency;
+            for (size_t i = begin; i < end; ++i) {
+                uint32_t v = order[i];
+                if (g.degree(v) == 0) continue;
+                frequency.clear();
+                for (uint64_t arc = g.offsets[v]; arc < g.offsets[v + 1]; ++arc) {
+                    frequency[label[g.neighbors[arc]].load(memory_order_relaxed)] += arcWeight(g, arc);
+                }
+                uint32_t current = label[v].load(memory_order_relaxed);
+                uint32_t best = current;
+                double bestWeight = frequency.count(current) ? frequency[current] : 0.0;
+                for (const auto &entry : frequency) {
+                    if (entry.second > bestWeight || (entry.second == bestWeight && entry.first < best && best != current)) {
+                        best = entry.first;
+                        bestWeight = entry.second;
+                    }
+                }
+                if (best != current) {
+                    label[v].store(best, memory_order_relaxed);
+                    ++partialChanged[worker];
+                }
+            }
+        });
+        uint64_t changed = 0;
+        for (uint64_t c : partialChanged) changed += c;
+        if (changed * 1000 < n) break;
+    }
+
+    CommunityAssignment result;
+    result.community.resize(n);
+    for (uint32_t v = 0; v < n; ++v) result.community[v] = label[v].load(memory_order_relaxed);
+    result.communityCount = compactLabels(result.community);
+    result.modularity = computeModularity(g, result.community);
+    return result;
+}
+
+// Atomically adds `delta` to a double (C++17 has no atomic<double>::fetch_add)
+inline void atomicAdd(atomic<double> &target, double delta) {
+    double current = target.load(memory_order_relaxed);
+    while (!target.compare_exchange_weak(current, current + delta, memory_order_relaxed)) {
+    }
+}
+
+// One level of parallel Louvain local moving (PLM-style). Threads sweep the vertices in a random order
+// and move each one in place to the neighboring community with the best modularity gain, updating
+// community totals atomically; concurrent moves may see slightly stale totals, which only costs extra
+// rounds. Stops when a round moves nothing or improves modularity by less than minGain.
+vector<uint32_t> louvainLocalMoving(const CSRGraph &g, int maxRounds, double minGain) {
+    const uint32_t n = g.numVertices();
+    vector<double> strength(n, 0.0);
+    double twoM = 0.0;
+    for (uint32_t v = 0; v < n; ++v) {
+        for (uint64_t arc = g.offsets[v]; arc < g.offsets[v + 1]; ++arc) strength[v] += arcWeight(g, arc);
+        twoM += strength[v];
+    }
+    vector<atomic<uint32_t>> community(n);
+    vector<atomic<double>> total(n);
+    for (uint32_t v = 0; v < n; ++v) {
+        community[v].store(v, memory_order_relaxed);
+        total[v].store(strength[v], memory_order_relaxed);
+    }
+
+    vector<uint32_t> result(n);
+    auto snapshotCommunities = [&]() {
+        for (uint32_t v = 0; v < n; ++v) result[v] = community[v].load(memory_order_relaxed);
+    };
+    snapshotCommunities();
+    if (twoM == 0.0) return result;
+
+    vector<uint32_t> order = samplePivots(n, n, n);
+    const unsigned threads = workerCount();
+    vector<uint64_t> partialMoves(threads);
+    double modularity = computeModularity(g, result);
+    for (int round = 0; round < maxRounds; ++round) {
+        fill(partialMoves.begin(), partialMoves.end(), 0);
+        parallelFor(n, 256, [&](size_t begin, size_t end, unsigned worker) {
+            unordered_map<uint32_t, double> linkWeight;
+            for (size_t i = begin; i < end; ++i) {
+                uint32_t v = order[i];
+                uint32_t current = community[v].load(memory_order_relaxed);
+                linkWeight.clear();
+                for (uint64_t arc = g.offsets[v]; arc < g.offsets[v + 1]; ++arc) {
+                    uint32_t u = g.neighbors[arc];
+                    if (u != v) linkWeight[community[u].load(memory_order_relaxed)] += arcWeight(g, arc);
+                }
+                // Gain of joining c once v is removed from its own community (constant factors dropped)
+                auto gain = [&](uint32_t c, double weightToC) {
+                    double tot = total[c].load(memory_order_relaxed) - (c == current ? strength[v] : 0.0);
+                    return weightToC - strength[v] * tot / twoM;
+                };
+                uint32_t best = current;
+                auto own = linkWeight.find(current);
+                double bestGain = gain(current, own == linkWeight.end() ? 0.0 : own->second);
+                for (const auto &entry : linkWeight) {
+                    double candidate = gain(entry.first, entry.second);
+                    if (candidate > bestGain || (candidate == bestGain && best != current && entry.first < best)) {
+                        best = entry.first;
+                        bestGain = candidate;
+                    }
+                }
+                if (best != current) {
+                    atomicAdd(total[current], -strength[v]);
+                    atomicAdd(total[best], strength[v]);
+                    community[v].store(best, memory_order_relaxed);
+                    ++partialMoves[worker];
+                }
+            }
+        });
+        uint64_t moves = 0;
+        for (uint64_t m : partialMoves) moves += m;
+        if (moves == 0) break;
+
+        snapshotCommunities();
+        double updated = computeModularity(g, result);
+        if (updated - modularity < minGain) break;
+        modularity = updated;
+    }
+    snapshotCommunities();
+    return result;
+}
+
+// Collapses each community into one vertex; the result has a self-loop arc carrying each community's
+// internal weight so modularity is preserved across levels
+CSRGraph aggregateCommunities(const CSRGraph &g, const vector<uint32_t> &community, uint32_t count) {
+    vector<vector<uint32_t>> members(count);
+    for (uint32_t v = 0; v < g.numVertices(); ++v) members[community[v]].push_back(v);
+
+    vector<vector<pair<uint32_t, float>>> rows(count);
+    parallelFor(count, 64, [&](size_t begin, size_t end, unsigned) {
+        unordered_map<uint32_t, double> weightTo;
+        for (size_t c = begin; c < end; ++c) {
+            weightTo.clear();
+            for (uint32_t v : members[c]) {
+                for (uint64_t arc = g.offsets[v]; arc < g.offsets[v + 1]; ++arc) {
+                    weightTo[community[g.neighbors[arc]]] += arcWeight(g, arc);
+                }
+            }
+            rows[c].assign(weightTo.begin(), weightTo.end());
+            std::sort(rows[c].begin(), rows[c].end());
+        }
+    });
+
+    CSRGraph coarse;
+    coarse.offsets.assign(count + 1, 0);
+    for (uint32_t c = 0; c < count; ++c) coarse.offsets[c + 1] = coarse.offsets[c] + rows[c].size();
+    coarse.neighbors.resize(coarse.offsets[count]);
+    coarse.weights.resize(coarse.offsets[count]);
+    for (uint32_t c = 0; c < count; ++c) {
+        uint64_t out = coarse.offsets[c];
+        for (const auto &arc : rows[c]) {
+            coarse.neighbors[out] = arc.first;
+            coarse.weights[out++] = arc.second;
+        }
+    }
+    return coarse;
+}
+
+// Multi-level parallel Louvain: alternate local moving and aggregation until no level merges anything.
+// Communities that ended up disconnected are finally split into their connected components (the
+// well-connectedness guarantee of Leiden's refinement step), which can only raise modularity.
+CommunityAssignment computeLouvain(const CSRGraph &g, int maxLevels) {
+    const uint32_t n = g.numVertices();
+    CommunityAssignment result;
+    result.community.resize(n);
+    for (uint32_t v = 0; v < n; ++v) result.community[v] = v;
+
+    CSRGraph level = g;
+    for (int depth = 0; depth < maxLevels; ++depth) {
+        vector<uint32_t> moved = louvainLocalMoving(level, 32, 1e-7);
+        uint32_t count = compactLabels(moved);
+        if (count == level.numVertices()) break;
+        for (uint32_t &c : result.community) c = moved[c];
+        level = aggregateCommunities(level, moved, count);
+    }
+
+    // Split disconnected communities with a BFS restricted to each community
+    vector<uint32_t> split(n, numeric_limits<uint32_t>::max());
+    vector<uint32_t> queue;
+    uint32_t next = 0;
+    for (uint32_t s = 0; s < n; ++s) {
+        if (split[s] != numeric_limits<uint32_t>::max()) continue;
+        split[s] = next;
+        queue.assign(1, s);
+        for (size_t head = 0; head < queue.size(); ++head) {
+            uint32_t u = queue[head];
+            for (const uint32_t *v = g.begin(u); v != g.end(u); ++v) {
+                if (split[*v] == numeric_limits<uint32_t>::max() && result.community[*v] == result.community[s]) {
+                    split[*v] = next;
+                    queue.push_back(*v);
+                }
+            }
+        }
+        ++next;
+    }
+    result.community.swap(split);
+    result.communityCount = next;
+    result.modularity = computeModularity(g, result.community);
+    return result;
+}
+
+// Vertex orderings that can be applied when the CSR snapshot is built
+enum class ReorderStrategy {
+    None,             // Keep insertion order
+    DegreeDescending, // Hubs first, so the hottest rows share cache lines
+    BFS,              // Breadth-first order from the highest-degree vertex of each component
+    ReverseCuthillMcKee, // Bandwidth-reducing BFS from a low-degree vertex, neighbors by ascending degree
+    Gorder            // Greedy window ordering maximizing shared neighbors among nearby IDs
 };
 
-// Adds a new user to the social network
-void SocialNetwork::addUser(const string &userName) {
-    if (adj.find(userName) == adj.end()) {
-        adj[userName] = set<string>(); // Create an empty set for the new user's friends
-        cout << "User '" << userName << "' added." << endl;
+// Renumbers a graph so that vertex order[i] becomes vertex i; rows are re-sorted in the new IDs
+CSRGraph permuteGraph(const CSRGraph &g, const vector<uint32_t> &order) {
+    const uint32_t n = g.numVertices();
+    vector<uint32_t> newId(n);
+    for (uint32_t i = 0; i < n; ++i) newId[order[i]] = i;
+
+    CSRGraph result;
+    result.offsets.assign(n + 1, 0);
+    for (uint32_t i = 0; i < n; ++i) result.offsets[i + 1] = result.offsets[i] + g.degree(order[i]);
+    result.neighbors.resize(g.numArcs());
+    if (!g.weights.empty()) result.weights.resize(g.numArcs());
+    if (!g.times.empty()) result.times.resize(g.numArcs());
+    parallelFor(n, 1024, [&](size_t begin, size_t end, unsigned) {
+        vector<tuple<uint32_t, float, int64_t>> row;
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t v = order[i];
+            row.clear();
+            for (uint64_t arc = g.offsets[v]; arc < g.offsets[v + 1]; ++arc) {
+                row.emplace_back(newId[g.neighbors[arc]], g.weights.empty() ? 1.0f : g.weights[arc],
+                                 g.times.empty() ? 0 : g.times[arc]);
+            }
+            std::sort(row.begin(), row.end());
+            uint64_t out = result.offsets[i];
+            for (const auto &arc : row) {
+                result.neighbors[out] = get<0>(arc);
+                if (!result.weights.empty()) result.weights[out] = get<1>(arc);
+                if (!result.times.empty()) result.times[out] = get<2>(arc);
+                ++out;
+            }
+        }
+    });
+    if (!result.times.empty()) buildTimeIndex(result);
+    return result;
+}
+
+// Vertices sorted by degree (descending), ties by ID
+vector<uint32_t> degreeDescendingOrder(const CSRGraph &g) {
+    vector<uint32_t> order(g.numVertices());
+    for (uint32_t v = 0; v < order.size(); ++v) order[v] = v;
+    std::stable_sort(order.begin(), order.end(), [&g](uint32_t a, uint32_t b) { return g.degree(a) > g.degree(b); });
+    return order;
+}
+
+// Breadth-first order covering every component. Components are started from `starts` in sequence;
+// with byDegree set, each vertex's unvisited neighbors are enqueued by ascending degree (Cuthill-McKee).
+vector<uint32_t> breadthFirstOrder(const CSRGraph &g, const vector<uint32_t> &starts, bool byDegree) {
+    const uint32_t n = g.numVertices();
+    vector<char> visited(n, 0);
+    vector<uint32_t> order;
+    order.reserve(n);
+    for (uint32_t s : starts) {
+        if (visited[s]) continue;
+        visited[s] = 1;
+        order.push_back(s);
+        for (size_t head = order.size() - 1; head < order.size(); ++head) {
+            uint32_t u = order[head];
+            size_t firstChild = order.size();
+            for (const uint32_t *v = g.begin(u); v != g.end(u); ++v) {
+                if (!visited[*v]) {
+                    visited[*v] = 1;
+                    order.push_back(*v);
+                }
+            }
+            if (byDegree) {
+                std::stable_sort(order.begin() + firstChild, order.end(),
+                                 [&g](uint32_t a, uint32_t b) { return g.degree(a) < g.degree(b); });
+            }
+        }
+    }
+    return order;
+}
+
+// Gorder (Wei et al.): greedily appends the unplaced vertex with the highest score, where the score
+// counts edges and shared neighbors with the last `window` placed vertices. Neighbors with degree above
+// hubLimit are not expanded when counting shared neighbors, which bounds the O(sum d^2) work on hubs.
+vector<uint32_t> gorderOrder(const CSRGraph &g, uint32_t window) {
+    const uint32_t n = g.numVertices();
+    const uint32_t hubLimit = max<uint32_t>(64, static_cast<uint32_t>(sqrt(static_cast<double>(n))));
+    vector<int64_t> score(n, 0);
+    vector<char> placed(n, 0);
+    priority_queue<pair<int64_t, uint32_t>> heap; // Lazy max-heap: stale entries are skipped on pop
+    vector<uint32_t> byDegree = degreeDescendingOrder(g);
+    size_t fallback = 0;
+
+    auto update = [&](uint32_t u, int64_t delta) {
+        auto bump = [&](uint32_t x) {
+            if (placed[x]) return;
+            score[x] += delta;
+            heap.emplace(score[x], x);
+        };
+        for (const uint32_t *x = g.begin(u); x != g.end(u); ++x) {
+            bump(*x);
+            if (g.degree(*x) > hubLimit) continue;
+            for (const uint32_t *y = g.begin(*x); y != g.end(*x); ++y) {
+                if (*y != u) bump(*y);
+            }
+        }
+    };
+
+    vector<uint32_t> order;
+    order.reserve(n);
+    while (order.size() < n) {
+        uint32_t v = n;
+        while (!heap.empty()) {
+            pair<int64_t, uint32_t> top = heap.top();
+            heap.pop();
+            if (!placed[top.second] && score[top.second] == top.first && top.first > 0) {
+                v = top.second;
+                break;
+            }
+        }
+        if (v == n) {
+            // Nothing in the window is related to any unplaced vertex: start from the next-largest hub
+            while (placed[byDegree[fallback]]) ++fallback;
+            v = byDegree[fallback];
+        }
+        placed[v] = 1;
+        order.push_back(v);
+        update(v, 1);
+        if (order.size() > window) update(order[order.size() - window - 1], -1);
+        // Keep the lazy heap from growing without bound
+        if (heap.size() > 8 * size_t(n) + 1024) {
+            priority_queue<pair<int64_t, uint32_t>> fresh;
+            for (uint32_t x = 0; x < n; ++x) {
+                if (!placed[x] && score[x] > 0) fresh.emplace(score[x], x);
+            }
+            heap.swap(fresh);
+        }
+    }
+    return order;
+}
+
+// Computes a locality-improving vertex order: order[i] is the old ID placed at new ID i
+vector<uint32_t> computeReordering(const CSRGraph &g, ReorderStrategy strategy) {
+    const uint32_t n = g.numVertices();
+    switch (strategy) {
+    case ReorderStrategy::DegreeDescending:
+        return degreeDescendingOrder(g);
+    case ReorderStrategy::BFS:
+        return breadthFirstOrder(g, degreeDescendingOrder(g), false);
+    case ReorderStrategy::ReverseCuthillMcKee: {
+        vector<uint32_t> starts = degreeDescendingOrder(g);
+        std::reverse(starts.begin(), starts.end()); // Low-degree (peripheral) vertices start each component
+        vector<uint32_t> order = breadthFirstOrder(g, starts, true);
+        std::reverse(order.begin(), order.end());
+        return order;
+    }
+    case ReorderStrategy::Gorder:
+        return gorderOrder(g, 5);
+    case ReorderStrategy::None:
+        break;
+    }
+    vector<uint32_t> identity(n);
+    for (uint32_t v = 0; v < n; ++v) identity[v] = v;
+    return identity;
+}
+
+// Read-only CSR whose sorted neighbor lists are stored as gaps in StreamVByte format: values are
+// grouped by 4, with one control byte holding each value's byte length (1-4), followed by the
+// little-endian value bytes. Lists are cut into blocks of kBlockSize values. Lists longer than one
+// block start with a skip table of (value before block, block byte offset) pairs, so a cursor can
+// jump straight to the block containing a target ID.
+struct CompressedCSRGraph {
+    static constexpr uint32_t kBlockSize = 128;
+
+    vector<uint64_t> offsets; // Byte offset of each vertex's encoded list in `data`
+    vector<uint32_t> degrees;
+    vector<uint8_t> data;     // Followed by 16 bytes of padding so SIMD loads never run off the end
+
+    uint32_t numVertices() const { return static_cast<uint32_t>(degrees.size()); }
+    uint32_t degree(uint32_t v) const { return degrees[v]; }
+    size_t bytesUsed() const {
+        return data.size() + offsets.size() * sizeof(uint64_t) + degrees.size() * sizeof(uint32_t);
+    }
+};
+
+// Shuffle masks and data lengths for StreamVByte groups, indexed by control byte
+struct StreamVByteTables {
+    uint8_t shuffle[256][16];
+    uint8_t length[256];
+
+    StreamVByteTables() {
+        for (int control = 0; control < 256; ++control) {
+            int source = 0;
+            for (int i = 0; i < 4; ++i) {
+                int bytes = ((control >> (2 * i)) & 3) + 1;
+                for (int b = 0; b < 4; ++b) {
+                    shuffle[control][4 * i + b] = static_cast<uint8_t>(b < bytes ? source + b : 0xFF);
+                }
+                source += bytes;
+            }
+            length[control] = static_cast<uint8_t>(source);
+        }
+    }
+};
+
+inline const StreamVByteTables &streamVByteTables() {
+    static const StreamVByteTables tables;
+    return tables;
+}
+
+// Appends `count` values as StreamVByte-encoded gaps from `previous`
+void encodeStreamVByteBlock(const uint32_t *values, uint32_t count, uint32_t previous, vector<uint8_t> &out) {
+    size_t control = out.size();
+    out.resize(out.size() + (count + 3) / 4, 0);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t gap = values[i] - previous;
+        previous = values[i];
+        uint32_t bytes = gap < (1u << 8) ? 1 : gap < (1u << 16) ? 2 : gap < (1u << 24) ? 3 : 4;
+        out[control + i / 4] |= static_cast<uint8_t>((bytes - 1) << (2 * (i % 4)));
+        for (uint32_t b = 0; b < bytes; ++b) out.push_back(static_cast<uint8_t>(gap >> (8 * b)));
+    }
+}
+
+// Decodes `count` gap-coded values into `out`, adding the running sum to `previous`.
+// Uses SSSE3 byte shuffles when available, otherwise a scalar loop.
+void decodeStreamVByteBlock(const uint8_t *in, uint32_t count, uint32_t previous, uint32_t *out) {
+    const uint8_t *control = in;
+    const uint8_t *bytes = in + (count + 3) / 4;
+    uint32_t i = 0;
+#ifdef __SSSE3__
+    const StreamVByteTables &tables = streamVByteTables();
+    __m128i prev = _mm_set1_epi32(static_cast<int>(previous));
+    for (; i + 4 <= count; i += 4) {
+        uint8_t c = control[i / 4];
+        __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes));
+        __m128i gaps = _mm_shuffle_epi8(raw, _mm_loadu_si128(reinterpret_cast<const __m128i *>(tables.shuffle[c])));
+        // In-register prefix sum of the four gaps, then add the last decoded value
+        gaps = _mm_add_epi32(gaps, _mm_slli_si128(gaps, 4));
+        gaps = _mm_add_epi32(gaps, _mm_slli_si128(gaps, 8));
+        prev = _mm_add_epi32(gaps, _mm_shuffle_epi32(prev, 0xFF));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), prev);
+        bytes += tables.length[c];
+    }
+    if (i > 0) previous = out[i - 1];
+#endif
+    for (; i < count; ++i) {
+        uint32_t length = ((control[i / 4] >> (2 * (i % 4))) & 3) + 1;
+        uint32_t gap = 0;
+        for (uint32_t b = 0; b < length; ++b) gap |= static_cast<uint32_t>(bytes[b]) << (8 * b);
+        bytes += length;
+        previous += gap;
+        out[i] = previous;
+    }
+}
+
+// Builds a CompressedCSRGraph one vertex at a time, so a graph can be compressed without first
+// materializing the plain CSR
+class CompressedCSRBuilder {
+private:
+    CompressedCSRGraph graph;
+
+public:
+    // Appends the next vertex's neighbor list (sorted ascending, no duplicates)
+    void appendVertex(const uint32_t *neighbors, uint32_t degree) {
+        const uint32_t block = CompressedCSRGraph::kBlockSize;
+        vector<uint8_t> &out = graph.data;
+        graph.offsets.push_back(out.size());
+        graph.degrees.push_back(degree);
+
+        uint32_t blocks = (degree + block - 1) / block;
+        size_t skipTable = out.size();
+        if (blocks > 1) out.resize(out.size() + (blocks - 1) * 8);
+        size_t listStart = out.size();
+        for (uint32_t b = 0; b < blocks; ++b) {
+            uint32_t first = b * block;
+            uint32_t previous = b == 0 ? 0 : neighbors[first - 1];
+            if (b > 0) {
+                uint32_t entry[2] = {previous, static_cast<uint32_t>(out.size() - listStart)};
+                memcpy(out.data() + skipTable + (b - 1) * 8, entry, 8);
+            }
+            encodeStreamVByteBlock(neighbors + first, min(block, degree - first), previous, out);
+        }
+    }
+
+    CompressedCSRGraph finish() {
+        graph.offsets.push_back(graph.data.size());
+        graph.data.resize(graph.data.size() + 16, 0);
+        graph.data.shrink_to_fit();
+        return std::move(graph);
+    }
+};
+
+// Compresses a CSR snapshot (same vertex IDs)
+CompressedCSRGraph compressGraph(const CSRGraph &g) {
+    CompressedCSRBuilder builder;
+    for (uint32_t v = 0; v < g.numVertices(); ++v) builder.appendVertex(g.begin(v), g.degree(v));
+    return builder.finish();
+}
+
+// Forward iterator over one compressed neighbor list, decoding a block at a time.
+// seek() uses the skip table to jump over blocks that cannot contain the target.
+class CompressedNeighborCursor {
+private:
+    const CompressedCSRGraph &g;
+    const uint8_t *skipTable;
+    const uint8_t *blocks;
+    uint32_t degree, blockCount, block, position, blockLength;
+    uint32_t buffer[CompressedCSRGraph::kBlockSize];
+
+    void loadBlock(uint32_t b) {
+        block = b;
+        position = 0;
+        if (b >= blockCount) {
+            blockLength = 0;
+            return;
+        }
+        uint32_t entry[2] = {0, 0};
+        if (b > 0) memcpy(entry, skipTable + (b - 1) * 8, 8);
+        blockLength = min(CompressedCSRGraph::kBlockSize, degree - b * CompressedCSRGraph::kBlockSize);
+        decodeStreamVByteBlock(blocks + entry[1], blockLength, entry[0], buffer);
+    }
+
+    // Largest value before block b (block b >= 1)
+    uint32_t valueBefore(uint32_t b) const {
+        uint32_t value;
+        memcpy(&value, skipTable + (b - 1) * 8, 4);
+        return value;
+    }
+
+public:
+    CompressedNeighborCursor(const CompressedCSRGraph &graph, uint32_t v) : g(graph) {
+        degree = g.degree(v);
+        blockCount = (degree + CompressedCSRGraph::kBlockSize - 1) / CompressedCSRGraph::kBlockSize;
+        skipTable = g.data.data() + g.offsets[v];
+        blocks = skipTable + (blockCount > 1 ? (blockCount - 1) * 8 : 0);
+        loadBlock(0);
+    }
+
+    bool valid() const { return position < blockLength; }
+    uint32_t value() const { return buffer[position]; }
+
+    void next() {
+        if (++position == blockLength) loadBlock(block + 1);
+    }
+
+    // Advances to the first neighbor >= target
+    void seek(uint32_t target) {
+        if (!valid() || value() >= target) return;
+        uint32_t b = block;
+        while (b + 1 < blockCount && valueBefore(b + 1) < target) ++b;
+        if (b != block) loadBlock(b);
+        position = static_cast<uint32_t>(std::lower_bound(buffer + position, buffer + blockLength, target) - buffer);
+        if (position == blockLength) loadBlock(block + 1);
+    }
+};
+
+// Calls f(neighbor) for every neighbor of v, decoding on the fly
+template <typename F>
+void forEachCompressedNeighbor(const CompressedCSRGraph &g, uint32_t v, F f) {
+    for (CompressedNeighborCursor cursor(g, v); cursor.valid(); cursor.next()) f(cursor.value());
+}
+
+// Intersects two compressed neighbor lists by leapfrogging cursors; skip pointers let a short list
+// jump over whole blocks of a hub's list
+vector<uint32_t> compressedIntersection(const CompressedCSRGraph &g, uint32_t u, uint32_t v) {
+    vector<uint32_t> common;
+    CompressedNeighborCursor a(g, u), b(g, v);
+    while (a.valid() && b.valid()) {
+        if (a.value() < b.value()) {
+            a.seek(b.value());
+        } else if (b.value() < a.value()) {
+            b.seek(a.value());
+        } else {
+            common.push_back(a.value());
+            a.next();
+            b.next();
+        }
+    }
+    return common;
+}
+
+// BFS shortest path on the compressed graph; returns the vertex path (empty if unreachable)
+vector<uint32_t> compressedShortestPath(const CompressedCSRGraph &g, uint32_t start, uint32_t end) {
+    const uint32_t unvisited = numeric_limits<uint32_t>::max();
+    vector<uint32_t> parent(g.numVertices(), unvisited), frontier{start}, path;
+    parent[start] = start;
+    bool found = start == end;
+    for (size_t head = 0; head < frontier.size() && !found; ++head) {
+        uint32_t current = frontier[head];
+        for (CompressedNeighborCursor cursor(g, current); cursor.valid(); cursor.next()) {
+            uint32_t neighbor = cursor.value();
+            if (parent[neighbor] != unvisited) continue;
+            parent[neighbor] = current;
+            frontier.push_back(neighbor);
+            if (neighbor == end) {
+                found = true;
+                break;
+            }
+        }
+    }
+    if (!found) return path;
+    for (uint32_t current = end; current != start; current = parent[current]) path.push_back(current);
+    path.push_back(start);
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+// MSB-first bit writer for the WebGraph codec
+class BitWriter {
+private:
+    vector<uint8_t> bytes;
+    uint64_t bitCount = 0;
+
+public:
+    void writeBits(uint64_t value, int length) {
+        for (int i = length - 1; i >= 0; --i) {
+            if ((bitCount & 7) == 0) bytes.push_back(0);
+            if ((value >> i) & 1) bytes.back() |= static_cast<uint8_t>(0x80 >> (bitCount & 7));
+            ++bitCount;
+        }
+    }
+
+    // Elias gamma code of value >= 0 (codes value + 1)
+    void writeGamma(uint64_t value) {
+        ++value;
+        int bits = 64 - __builtin_clzll(value);
+        writeBits(0, bits - 1);
+        writeBits(value, bits);
+    }
+
+    // Boldi-Vigna zeta_3 code of value >= 0 (codes value + 1): unary bucket h, then a minimal
+    // binary code within [2^(3h), 2^(3h+3)); suited to the power-law gaps of social graphs
+    void writeZeta3(uint64_t value) {
+        ++value;
+        int h = (63 - __builtin_clzll(value)) / 3;
+        writeBits(1, h + 1);
+        uint64_t offset = value - (uint64_t(1) << (3 * h));
+        uint64_t m = uint64_t(1) << (3 * h); // 2^s - interval size, with s = 3h + 3
+        if (offset < m) {
+            writeBits(offset, 3 * h + 2);
+        } else {
+            writeBits(offset + m, 3 * h + 3);
+        }
+    }
+
+    uint64_t position() const { return bitCount; }
+
+    // Returns the encoded bytes, padded so readers can always load 8 bytes at once
+    vector<uint8_t> finish() {
+        bytes.resize(bytes.size() + 8, 0);
+        return std::move(bytes);
+    }
+};
+
+// MSB-first bit reader matching BitWriter; requires 8 bytes of padding after the data
+class BitReader {
+private:
+    const uint8_t *data;
+    uint64_t bitPosition;
+
+    // The next 57+ bits, left-aligned
+    uint64_t peek() const {
+        uint64_t word;
+        memcpy(&word, data + (bitPosition >> 3), 8);
+        return __builtin_bswap64(word) << (bitPosition & 7);
+    }
+
+public:
+    BitReader(const uint8_t *bytes, uint64_t position) : data(bytes), bitPosition(position) {}
+
+    uint64_t readBits(int length) {
+        if (length == 0) return 0;
+        uint64_t value = peek() >> (64 - length);
+        bitPosition += length;
+        return value;
+    }
+
+    uint64_t readGamma() {
+        int zeros = __builtin_clzll(peek());
+        bitPosition += zeros;
+        return readBits(zeros + 1) - 1;
+    }
+
+    uint64_t readZeta3() {
+        int h = __builtin_clzll(peek());
+        bitPosition += h + 1;
+        uint64_t m = uint64_t(1) << (3 * h);
+        uint64_t offset = readBits(3 * h + 2);
+        if (offset >= m) offset = ((offset << 1) | readBits(1)) - m;
+        return offset + m - 1;
+    }
+};
+
+// Maps a signed value to a natural number (0, -1, 1, -2, ... -> 0, 1, 2, 3, ...) and back
+inline uint64_t int2nat(int64_t x) { return x >= 0 ? uint64_t(x) << 1 : (uint64_t(-x) << 1) - 1; }
+inline int64_t nat2int(uint64_t x) { return (x & 1) ? -static_cast<int64_t>((x + 1) >> 1) : static_cast<int64_t>(x >> 1); }
+
+// BV/WebGraph-style compressed graph. Each list is coded as: degree; a reference to one of the
+// previous kWindow lists whose elements are copied through run-length copy blocks; runs of at least
+// kMinInterval consecutive IDs as intervals; and the remaining residuals as zeta_3-coded gaps.
+// Reference chains are capped at kMaxReferenceChain so random access stays cheap.
+struct WebGraphCompressed {
+    static constexpr uint32_t kWindow = 7;
+    static constexpr uint32_t kMaxReferenceChain = 3;
+    static constexpr uint32_t kMinInterval = 4;
+
+    vector<uint8_t> bits;
+    vector<uint64_t> offsets; // Bit offset of each vertex's list (the random-access index)
+    uint64_t arcs = 0;
+
+    uint32_t numVertices() const { return static_cast<uint32_t>(offsets.size()); }
+    size_t bytesUsed() const { return bits.size() + offsets.size() * sizeof(uint64_t); }
+};
+
+// Encodes one successor list of vertex x, optionally against reference list `ref` at distance r
+void encodeWebGraphList(BitWriter &out, uint32_t x, const uint32_t *succ, uint32_t degree, const uint32_t *ref,
+                        uint32_t refDegree, uint32_t r) {
+    out.writeGamma(degree);
+    if (degree == 0) return;
+    out.writeGamma(r);
+
+    vector<uint32_t> extras;
+    if (r > 0) {
+        // Run lengths over the reference list, alternating copy / skip and starting with copy
+        vector<uint32_t> blocks;
+        bool copying = true;
+        uint32_t run = 0;
+        const uint32_t *s = succ, *sEnd = succ + degree;
+        for (uint32_t i = 0; i < refDegree; ++i) {
+            while (s != sEnd && *s < ref[i]) extras.push_back(*s++);
+            bool present = s != sEnd && *s == ref[i];
+            if (present) ++s;
+            if (present != copying) {
+                blocks.push_back(run);
+                copying = present;
+                run = 0;
+            }
+            ++run;
+        }
+        extras.insert(extras.end(), s, sEnd);
+        // The final run is implicit: its parity follows from the number of explicit blocks
+        out.writeGamma(blocks.size());
+        for (size_t i = 0; i < blocks.size(); ++i) out.writeGamma(i == 0 ? blocks[i] : blocks[i] - 1);
+    } else {
+        extras.assign(succ, succ + degree);
+    }
+
+    // Split extras into intervals (runs of consecutive IDs) and residuals
+    vector<pair<uint32_t, uint32_t>> intervals; // (left, length)
+    vector<uint32_t> residuals;
+    for (size_t i = 0; i < extras.size();) {
+        size_t j = i + 1;
+        while (j < extras.size() && extras[j] == extras[j - 1] + 1) ++j;
+        if (j - i >= WebGraphCompressed::kMinInterval) {
+            intervals.emplace_back(extras[i], static_cast<uint32_t>(j - i));
+        } else {
+            residuals.insert(residuals.end(), extras.begin() + i, extras.begin() + j);
+        }
+        i = j;
+    }
+    out.writeGamma(intervals.size());
+    uint64_t previousEnd = 0;
+    for (size_t i = 0; i < intervals.size(); ++i) {
+        if (i == 0) {
+            out.writeGamma(int2nat(int64_t(intervals[i].first) - x));
+        } else {
+            out.writeGamma(intervals[i].first - previousEnd - 1);
+        }
+        out.writeGamma(intervals[i].second - WebGraphCompressed::kMinInterval);
+        previousEnd = uint64_t(intervals[i].first) + intervals[i].second;
+    }
+    for (size_t i = 0; i < residuals.size(); ++i) {
+        if (i == 0) {
+            out.writeZeta3(int2nat(int64_t(residuals[i]) - x));
+        } else {
+            out.writeZeta3(residuals[i] - residuals[i - 1] - 1);
+        }
+    }
+}
+
+// Decodes the list of vertex x; referenceList(r) must return the decoded list of x - r
+template <typename ReferenceList>
+void decodeWebGraphList(BitReader &in, uint32_t x, vector<uint32_t> &out, ReferenceList referenceList) {
+    out.clear();
+    uint32_t degree = static_cast<uint32_t>(in.readGamma());
+    if (degree == 0) return;
+    uint32_t r = static_cast<uint32_t>(in.readGamma());
+
+    vector<uint32_t> copied;
+    if (r > 0) {
+        const vector<uint32_t> &ref = referenceList(r);
+        uint32_t blockCount = static_cast<uint32_t>(in.readGamma());
+        size_t i = 0;
+        for (uint32_t b = 0; b < blockCount; ++b) {
+            size_t length = b == 0 ? in.readGamma() : in.readGamma() + 1;
+            if (b % 2 == 0) copied.insert(copied.end(), ref.begin() + i, ref.begin() + i + length);
+            i += length;
+        }
+        if (blockCount % 2 == 0) copied.insert(copied.end(), ref.begin() + i, ref.end());
+    }
+
+    vector<uint32_t> extras;
+    uint32_t intervalCount = static_cast<uint32_t>(in.readGamma());
+    uint64_t previousEnd = 0;
+    for (uint32_t i = 0; i < intervalCount; ++i) {
+        uint64_t left = i == 0 ? x + nat2int(in.readGamma()) : previousEnd + 1 + in.readGamma();
+        uint64_t length = in.readGamma() + WebGraphCompressed::kMinInterval;
+        for (uint64_t v = left; v < left + length; ++v) extras.push_back(static_cast<uint32_t>(v));
+        previousEnd = left + length;
+    }
+    size_t intervalEnd = extras.size();
+    size_t residualCount = degree - copied.size() - intervalEnd;
+    int64_t previous = 0;
+    for (size_t i = 0; i < residualCount; ++i) {
+        previous = i == 0 ? int64_t(x) + nat2int(in.readZeta3()) : previous + 1 + int64_t(in.readZeta3());
+        extras.push_back(static_cast<uint32_t>(previous));
+    }
+    std::inplace_merge(extras.begin(), extras.begin() + intervalEnd, extras.end());
+    out.resize(degree);
+    std::merge(copied.begin(), copied.end(), extras.begin(), extras.end(), out.begin());
+}
+
+// Compresses a CSR snapshot, choosing for each list the reference in the window that codes shortest
+WebGraphCompressed webGraphCompress(const CSRGraph &g) {
+    const uint32_t n = g.numVertices();
+    WebGraphCompressed result;
+    result.offsets.resize(n);
+    result.arcs = g.numArcs();
+    vector<uint32_t> chain(n, 0);
+    BitWriter out;
+    for (uint32_t x = 0; x < n; ++x) {
+        uint32_t bestR = 0;
+        uint64_t bestCost = numeric_limits<uint64_t>::max();
+        for (uint32_t r = 0; r <= WebGraphCompressed::kWindow && r <= x; ++r) {
+            if (r > 0 && (chain[x - r] >= WebGraphCompressed::kMaxReferenceChain || g.degree(x - r) == 0)) continue;
+            BitWriter trial;
+            encodeWebGraphList(trial, x, g.begin(x), g.degree(x), r ? g.begin(x - r) : nullptr, r ? g.degree(x - r) : 0, r);
+            if (trial.position() < bestCost) {
+                bestCost = trial.position();
+                bestR = r;
+            }
+            if (g.degree(x) == 0) break;
+        }
+        chain[x] = bestR ? chain[x - bestR] + 1 : 0;
+        result.offsets[x] = out.position();
+        encodeWebGraphList(out, x, g.begin(x), g.degree(x), bestR ? g.begin(x - bestR) : nullptr,
+                           bestR ? g.degree(x - bestR) : 0, bestR);
+    }
+    result.bits = out.finish();
+    return result;
+}
+
+// Random access: decodes the successors of x through the offsets index, following references
+void webGraphSuccessors(const WebGraphCompressed &g, uint32_t x, vector<uint32_t> &out) {
+    BitReader in(g.bits.data(), g.offsets[x]);
+    vector<uint32_t> ref;
+    decodeWebGraphList(in, x, out, [&](uint32_t r) -> const vector<uint32_t> & {
+        webGraphSuccessors(g, x - r, ref);
+        return ref;
+    });
+}
+
+// Sequential decoder: walks vertices in order, keeping the last kWindow lists so references are
+// resolved from memory instead of being decoded again
+class WebGraphSequentialReader {
+private:
+    const WebGraphCompressed &g;
+    BitReader in;
+    uint32_t nextVertex = 0;
+    vector<vector<uint32_t>> window;
+
+public:
+    explicit WebGraphSequentialReader(const WebGraphCompressed &graph)
+        : g(graph), in(graph.bits.data(), 0), window(WebGraphCompressed::kWindow + 1) {}
+
+    bool hasNext() const { return nextVertex < g.numVertices(); }
+
+    // Decodes the next vertex's successors; the reference stays valid until the window wraps around
+    const vector<uint32_t> &next() {
+        const size_t slots = window.size();
+        uint32_t x = nextVertex++;
+        decodeWebGraphList(in, x, window[x % slots],
+                           [&](uint32_t r) -> const vector<uint32_t> & { return window[(x - r) % slots]; });
+        return window[x % slots];
+    }
+};
+
+// Full-graph BFS distances from `source` using only sequential scans: each pass decodes the whole
+// graph once and expands the vertices of the current level, so a social graph with a small diameter
+// is traversed in a handful of streaming passes
+vector<int32_t> webGraphBFS(const WebGraphCompressed &g, uint32_t source) {
+    vector<int32_t> dist(g.numVertices(), -1);
+    dist[source] = 0;
+    for (int32_t level = 0;; ++level) {
+        bool expanded = false;
+        WebGraphSequentialReader reader(g);
+        for (uint32_t x = 0; reader.hasNext(); ++x) {
+            const vector<uint32_t> &succ = reader.next();
+            if (dist[x] != level) continue;
+            for (uint32_t y : succ) {
+                if (dist[y] < 0) {
+                    dist[y] = level + 1;
+                    expanded = true;
+                }
+            }
+        }
+        if (!expanded) break;
+    }
+    return dist;
+}
+
+// Roaring-style compressed bitmap for hub neighbor sets. IDs are split by their high 16 bits into
+// chunks; a chunk holds a sorted array of low halves while sparse and a 65536-bit bitmap once it
+// exceeds kArrayLimit entries.
+class RoaringBitmap {
+public:
+    static constexpr uint32_t kArrayLimit = 4096;
+    using allocator_type = pmr::polymorphic_allocator<uint16_t>;
+
+    struct Chunk {
+        using allocator_type = pmr::polymorphic_allocator<uint16_t>;
+
+        uint16_t key = 0;
+        uint32_t cardinality = 0;
+        pmr::vector<uint16_t> array; // Used while bits is empty
+        pmr::vector<uint64_t> bits;  // 1024 words when the chunk is dense
+
+        explicit Chunk(const allocator_type &alloc = {}) : array(alloc), bits(alloc) {}
+        Chunk(const Chunk &other, const allocator_type &alloc)
+            : key(other.key), cardinality(other.cardinality), array(other.array, alloc), bits(other.bits, alloc) {}
+        Chunk(Chunk &&other, const allocator_type &alloc)
+            : key(other.key), cardinality(other.cardinality), array(std::move(other.array), alloc),
+              bits(std::move(other.bits), alloc) {}
+        Chunk(const Chunk &) = default;
+        Chunk(Chunk &&) = default;
+        Chunk &operator=(const Chunk &) = default;
+        Chunk &operator=(Chunk &&) = default;
+
+        bool isBitmap() const { return !bits.empty(); }
+        bool contains(uint16_t low) const {
+            if (isBitmap()) return (bits[low >> 6] >> (low & 63)) & 1;
+            return std::binary_search(array.begin(), array.end(), low);
+        }
+    };
+
+private:
+    pmr::vector<Chunk> chunks; // Sorted by key
+    size_t count = 0;
+
+    pmr::vector<Chunk>::const_iterator findChunk(uint16_t key) const {
+        auto it = std::lower_bound(chunks.begin(), chunks.end(), key, [](const Chunk &c, uint16_t k) { return c.key < k; });
+        return it != chunks.end() && it->key == key ? it : chunks.end();
+    }
+
+public:
+    explicit RoaringBitmap(const allocator_type &alloc = {}) : chunks(alloc) {}
+    RoaringBitmap(const RoaringBitmap &other, const allocator_type &alloc) : chunks(other.chunks, alloc), count(other.count) {}
+    RoaringBitmap(const RoaringBitmap &) = default;
+    RoaringBitmap(RoaringBitmap &&) = default;
+    RoaringBitmap &operator=(const RoaringBitmap &) = default;
+    RoaringBitmap &operator=(RoaringBitmap &&) = default;
+
+    size_t size() const { return count; }
+    const pmr::vector<Chunk> &getChunks() const { return chunks; }
+
+    bool contains(uint32_t x) const {
+        auto it = findChunk(static_cast<uint16_t>(x >> 16));
+        return it != chunks.end() && it->contains(static_cast<uint16_t>(x));
+    }
+
+    // Returns true if x was not present
+    bool insert(uint32_t x) {
+        uint16_t key = static_cast<uint16_t>(x >> 16), low = static_cast<uint16_t>(x);
+        auto it = std::lower_bound(chunks.begin(), chunks.end(), key, [](const Chunk &c, uint16_t k) { return c.key < k; });
+        if (it == chunks.end() || it->key != key) {
+            it = chunks.emplace(it);
+            it->key = key;
+        }
+        Chunk &chunk = *it;
+        if (chunk.isBitmap()) {
+            uint64_t &word = chunk.bits[low >> 6];
+            uint64_t mask = uint64_t(1) << (low & 63);
+            if (word & mask) return false;
+            word |= mask;
+        } else {
+            auto pos = std::lower_bound(chunk.array.begin(), chunk.array.end(), low);
+            if (pos != chunk.array.end() && *pos == low) return false;
+            chunk.array.insert(pos, low);
+            if (chunk.array.size() > kArrayLimit) {
+                chunk.bits.assign(1024, 0);
+                for (uint16_t v : chunk.array) chunk.bits[v >> 6] |= uint64_t(1) << (v & 63);
+                chunk.array.clear();
+                chunk.array.shrink_to_fit();
+            }
+        }
+        ++chunk.cardinality;
+        ++count;
+        return true;
+    }
+
+    // Returns true if x was present
+    bool erase(uint32_t x) {
+        uint16_t key = static_cast<uint16_t>(x >> 16), low = static_cast<uint16_t>(x);
+        auto found = findChunk(key);
+        if (found == chunks.end()) return false;
+        Chunk &chunk = chunks[found - chunks.begin()];
+        if (chunk.isBitmap()) {
+            uint64_t &word = chunk.bits[low >> 6];
+            uint64_t mask = uint64_t(1) << (low & 63);
+            if (!(word & mask)) return false;
+            word &= ~mask;
+            if (chunk.cardinality - 1 <= kArrayLimit / 2) {
+                // Shrink back to an array once the chunk is clearly sparse
+                for (uint32_t w = 0; w < 1024; ++w) {
+                    for (uint64_t bits = chunk.bits[w]; bits; bits &= bits - 1) {
+                        chunk.array.push_back(static_cast<uint16_t>(w * 64 + __builtin_ctzll(bits)));
+                    }
+                }
+                chunk.bits.clear();
+                chunk.bits.shrink_to_fit();
+            }
+        } else {
+            auto pos = std::lower_bound(chunk.array.begin(), chunk.array.end(), low);
+            if (pos == chunk.array.end() || *pos != low) return false;
+            chunk.array.erase(pos);
+        }
+        --count;
+        if (--chunk.cardinality == 0) chunks.erase(found);
+        return true;
+    }
+
+    // Calls f(id) for every member in ascending order
+    template <typename F>
+    void forEach(F f) const {
+        for (const Chunk &chunk : chunks) {
+            uint32_t high = uint32_t(chunk.key) << 16;
+            if (chunk.isBitmap()) {
+                for (uint32_t w = 0; w < 1024; ++w) {
+                    for (uint64_t bits = chunk.bits[w]; bits; bits &= bits - 1) f(high | (w * 64 + __builtin_ctzll(bits)));
+                }
+            } else {
+                for (uint16_t low : chunk.array) f(high | low);
+            }
+        }
+    }
+};
+
+// Adaptive neighbor container: a few IDs inline (no heap allocation), a sorted vector for medium
+// degrees, and a RoaringBitmap for hubs. Promotes on insert and demotes (with hysteresis) on erase.
+// Allocator-aware: every heap block comes from the memory resource it was constructed with.
+class NeighborSet {
+public:
+    static constexpr uint32_t kInlineCapacity = 6;
+    static constexpr uint32_t kBitmapThreshold = 4096;
+    using allocator_type = pmr::polymorphic_allocator<uint32_t>;
+
+private:
+    struct InlineIds {
+        uint32_t size;
+        uint32_t ids[kInlineCapacity];
+        InlineIds() : size(0) {}
+    };
+    pmr::memory_resource *resource;
+    variant<InlineIds, pmr::vector<uint32_t>, RoaringBitmap> storage;
+
+    // Copies other's contents into this set's memory resource
+    void copyFrom(const NeighborSet &other) {
+        if (const InlineIds *small = std::get_if<InlineIds>(&other.storage)) {
+            storage = *small;
+        } else if (other.isBitmap()) {
+            storage.emplace<RoaringBitmap>(other.bitmap(), resource);
+        } else {
+            storage.emplace<pmr::vector<uint32_t>>(other.arrayBegin(), other.arrayEnd(), resource);
+        }
+    }
+
+public:
+    NeighborSet() : NeighborSet(allocator_type()) {}
+    explicit NeighborSet(const allocator_type &alloc) : resource(alloc.resource()) {}
+    NeighborSet(const NeighborSet &other, const allocator_type &alloc) : resource(alloc.resource()) { copyFrom(other); }
+    NeighborSet(NeighborSet &&other, const allocator_type &alloc) : resource(alloc.resource()) {
+        if (*resource == *other.resource) {
+            storage = std::move(other.storage);
+        } else {
+            copyFrom(other);
+        }
+    }
+    NeighborSet(const NeighborSet &other) : NeighborSet(other, allocator_type()) {}
+    NeighborSet(NeighborSet &&) = default;
+    NeighborSet &operator=(const NeighborSet &other) {
+        if (this != &other) copyFrom(other);
+        return *this;
+    }
+    NeighborSet &operator=(NeighborSet &&other) {
+        if (*resource == *other.resource) {
+            storage = std::move(other.storage);
+        } else {
+            copyFrom(other);
+        }
+        return *this;
+    }
+
+    bool isInline() const { return storage.index() == 0; }
+    bool isBitmap() const { return storage.index() == 2; }
+    const RoaringBitmap &bitmap() const { return std::get<RoaringBitmap>(storage); }
+
+    // Sorted IDs for the inline and vector representations (not valid for bitmaps)
+    const uint32_t *arrayBegin() const {
+        if (const InlineIds *small = std::get_if<InlineIds>(&storage)) return small->ids;
+        return std::get<pmr::vector<uint32_t>>(storage).data();
+    }
+    const uint32_t *arrayEnd() const {
+        if (const InlineIds *small = std::get_if<InlineIds>(&storage)) return small->ids + small->size;
+        const pmr::vector<uint32_t> &ids = std::get<pmr::vector<uint32_t>>(storage);
+        return ids.data() + ids.size();
+    }
+
+    size_t size() const {
+        if (isBitmap()) return bitmap().size();
+        return arrayEnd() - arrayBegin();
+    }
+
+    bool contains(uint32_t x) const {
+        if (isBitmap()) return bitmap().contains(x);
+        const uint32_t *begin = arrayBegin(), *end = arrayEnd();
+        if (end - begin <= static_cast<ptrdiff_t>(kInlineCapacity)) return std::find(begin, end, x) != end;
+        return std::binary_search(begin, end, x);
+    }
+
+    // Returns true if x was not present
+    bool insert(uint32_t x) {
+        if (RoaringBitmap *hub = std::get_if<RoaringBitmap>(&storage)) return hub->insert(x);
+        if (InlineIds *small = std::get_if<InlineIds>(&storage)) {
+            uint32_t *pos = std::lower_bound(small->ids, small->ids + small->size, x);
+            if (pos != small->ids + small->size && *pos == x) return false;
+            if (small->size < kInlineCapacity) {
+                std::copy_backward(pos, small->ids + small->size, small->ids + small->size + 1);
+                *pos = x;
+                ++small->size;
+                return true;
+            }
+            InlineIds full = *small;
+            storage.emplace<pmr::vector<uint32_t>>(full.ids, full.ids + full.size, resource);
+        }
+        pmr::vector<uint32_t> &ids = std::get<pmr::vector<uint32_t>>(storage);
+        auto pos = std::lower_bound(ids.begin(), ids.end(), x);
+        if (pos != ids.end() && *pos == x) return false;
+        ids.insert(pos, x);
+        if (ids.size() > kBitmapThreshold) {
+            RoaringBitmap hub(resource);
+            for (uint32_t id : ids) hub.insert(id);
+            storage = std::move(hub);
+        }
+        return true;
+    }
+
+    // Returns true if x was present
+    bool erase(uint32_t x) {
+        if (RoaringBitmap *hub = std::get_if<RoaringBitmap>(&storage)) {
+            if (!hub->erase(x)) return false;
+            if (hub->size() < kBitmapThreshold / 2) {
+                pmr::vector<uint32_t> ids(resource);
+                ids.reserve(hub->size());
+                hub->forEach([&ids](uint32_t id) { ids.push_back(id); });
+                storage = std::move(ids);
+            }
+            return true;
+        }
+        if (InlineIds *small = std::get_if<InlineIds>(&storage)) {
+            uint32_t *end = small->ids + small->size;
+            uint32_t *pos = std::lower_bound(small->ids, end, x);
+            if (pos == end || *pos != x) return false;
+            std::copy(pos + 1, end, pos);
+            --small->size;
+            return true;
+        }
+        pmr::vector<uint32_t> &ids = std::get<pmr::vector<uint32_t>>(storage);
+        auto pos = std::lower_bound(ids.begin(), ids.end(), x);
+        if (pos == ids.end() || *pos != x) return false;
+        ids.erase(pos);
+        if (ids.size() <= kInlineCapacity - 2) {
+            InlineIds small;
+            small.size = static_cast<uint32_t>(ids.size());
+            std::copy(ids.begin(), ids.end(), small.ids);
+            storage = small;
+        }
+        return true;
+    }
+
+    // Ensures room for `capacity` IDs, switching up to the representation that size calls for, so
+    // that a following mergeSorted on an array representation does not allocate
+    void reserve(size_t capacity) {
+        if (isBitmap()) return;
+        if (capacity > kBitmapThreshold) {
+            RoaringBitmap hub(resource);
+            forEach([&hub](uint32_t id) { hub.insert(id); });
+            storage = std::move(hub);
+            return;
+        }
+        if (InlineIds *small = std::get_if<InlineIds>(&storage)) {
+            if (capacity <= kInlineCapacity) return;
+            InlineIds full = *small;
+            storage.emplace<pmr::vector<uint32_t>>(full.ids, full.ids + full.size, resource);
+        }
+        // Grow geometrically so that repeated batches do not reallocate every time
+        pmr::vector<uint32_t> &ids = std::get<pmr::vector<uint32_t>>(storage);
+        if (capacity > ids.capacity()) ids.reserve(max(capacity, 2 * ids.capacity()));
+    }
+
+    // Applies sorted additions (none already present) and sorted removals (all present) in one
+    // merge pass. Never changes representation; call reserve() with the merged size first and shrink()
+    // afterwards.
+    void mergeSorted(const uint32_t *add, const uint32_t *addEnd, const uint32_t *remove, const uint32_t *removeEnd) {
+        if (RoaringBitmap *hub = std::get_if<RoaringBitmap>(&storage)) {
+            for (; remove != removeEnd; ++remove) hub->erase(*remove);
+            for (; add != addEnd; ++add) hub->insert(*add);
+            return;
+        }
+        uint32_t *ids;
+        size_t size;
+        if (InlineIds *small = std::get_if<InlineIds>(&storage)) {
+            ids = small->ids;
+            size = small->size;
+        } else {
+            pmr::vector<uint32_t> &vec = std::get<pmr::vector<uint32_t>>(storage);
+            ids = vec.data();
+            size = vec.size();
+        }
+
+        // Compact away removals front to back, then merge additions in from the back
+        size_t kept = 0;
+        for (size_t i = 0; i < size; ++i) {
+            while (remove != removeEnd && *remove < ids[i]) ++remove;
+            if (remove != removeEnd && *remove == ids[i]) continue;
+            ids[kept++] = ids[i];
+        }
+        size_t newSize = kept + (addEnd - add);
+        if (InlineIds *small = std::get_if<InlineIds>(&storage)) {
+            small->size = static_cast<uint32_t>(newSize);
+        } else {
+            pmr::vector<uint32_t> &vec = std::get<pmr::vector<uint32_t>>(storage);
+            vec.resize(newSize); // Within the reserved capacity
+            ids = vec.data();
+        }
+        for (size_t out = newSize; add != addEnd;) {
+            if (kept > 0 && ids[kept - 1] > addEnd[-1]) {
+                ids[--out] = ids[--kept];
+            } else {
+                ids[--out] = *--addEnd;
+            }
+        }
+    }
+
+    // Demotes a set that has become small, with the same thresholds as erase(): a bitmap back to a
+    // sorted vector, and a sorted vector back inline
+    void shrink() {
+        if (RoaringBitmap *hub = std::get_if<RoaringBitmap>(&storage)) {
+            if (hub->size() >= kBitmapThreshold / 2) return;
+            pmr::vector<uint32_t> ids(resource);
+            ids.reserve(hub->size());
+            hub->forEach([&ids](uint32_t id) { ids.push_back(id); });
+            storage = std::move(ids);
+        }
+        pmr::vector<uint32_t> *ids = std::get_if<pmr::vector<uint32_t>>(&storage);
+        if (ids && ids->size() <= kInlineCapacity - 2) {
+            InlineIds small;
+            small.size = static_cast<uint32_t>(ids->size());
+            std::copy(ids->begin(), ids->end(), small.ids);
+            storage = small;
+        }
+    }
+
+    // Calls f(id) for every neighbor in ascending order
+    template <typename F>
+    void forEach(F f) const {
+        if (isBitmap()) {
+            bitmap().forEach(f);
+            return;
+        }
+        for (const uint32_t *p = arrayBegin(); p != arrayEnd(); ++p) f(*p);
+    }
+};
+
+// Array-array kernel: linear merge, or galloping (exponential) search when one side is much shorter
+template <typename Out>
+void intersectSortedArrays(const uint32_t *a, const uint32_t *aEnd, const uint32_t *b, const uint32_t *bEnd,
+                           Out &out) {
+    if (aEnd - a > bEnd - b) {
+        swap(a, b);
+        swap(aEnd, bEnd);
+    }
+    if ((bEnd - b) > 32 * (aEnd - a)) {
+        for (; a != aEnd && b != bEnd; ++a) {
+            size_t step = 1;
+            while (b + step < bEnd && b[step] < *a) step <<= 1;
+            b = std::lower_bound(b + step / 2, min(b + step + 1, bEnd), *a);
+            if (b != bEnd && *b == *a) out.push_back(*a);
+        }
+        return;
+    }
+    while (a != aEnd && b != bEnd) {
+        if (*a < *b) {
+            ++a;
+        } else if (*b < *a) {
+            ++b;
+        } else {
+            out.push_back(*a);
+            ++a;
+            ++b;
+        }
+    }
+}
+
+// Array-bitmap kernel: probes the bitmap chunk by chunk, resolving each high-16 key once
+template <typename Out>
+void intersectArrayBitmap(const uint32_t *a, const uint32_t *aEnd, const RoaringBitmap &bitmap, Out &out) {
+    const pmr::vector<RoaringBitmap::Chunk> &chunks = bitmap.getChunks();
+    auto chunk = chunks.begin();
+    for (; a != aEnd && chunk != chunks.end(); ++a) {
+        uint16_t key = static_cast<uint16_t>(*a >> 16);
+        while (chunk != chunks.end() && chunk->key < key) ++chunk;
+        if (chunk != chunks.end() && chunk->key == key && chunk->contains(static_cast<uint16_t>(*a))) out.push_back(*a);
+    }
+}
+
+// Bitmap-bitmap kernel: matches chunk keys, then ANDs bitmap words or merges sparse arrays
+template <typename Out>
+void intersectBitmaps(const RoaringBitmap &a, const RoaringBitmap &b, Out &out) {
+    const pmr::vector<RoaringBitmap::Chunk> &ca = a.getChunks(), &cb = b.getChunks();
+    size_t i = 0, j = 0;
+    while (i < ca.size() && j < cb.size()) {
+        if (ca[i].key < cb[j].key) {
+            ++i;
+            continue;
+        }
+        if (cb[j].key < ca[i].key) {
+            ++j;
+            continue;
+        }
+        const RoaringBitmap::Chunk &x = ca[i++], &y = cb[j++];
+        uint32_t high = uint32_t(x.key) << 16;
+        if (x.isBitmap() && y.isBitmap()) {
+            for (uint32_t w = 0; w < 1024; ++w) {
+                for (uint64_t bits = x.bits[w] & y.bits[w]; bits; bits &= bits - 1) {
+                    out.push_back(high | (w * 64 + __builtin_ctzll(bits)));
+                }
+            }
+        } else if (x.isBitmap() || y.isBitmap()) {
+            const RoaringBitmap::Chunk &sparse = x.isBitmap() ? y : x, &dense = x.isBitmap() ? x : y;
+            for (uint16_t low : sparse.array) {
+                if (dense.contains(low)) out.push_back(high | low);
+            }
+        } else {
+            size_t p = 0, q = 0;
+            while (p < x.array.size() && q < y.array.size()) {
+                if (x.array[p] < y.array[q]) {
+                    ++p;
+                } else if (y.array[q] < x.array[p]) {
+                    ++q;
+                } else {
+                    out.push_back(high | x.array[p]);
+                    ++p;
+                    ++q;
+                }
+            }
+        }
+    }
+}
+
+// Intersects two neighbor sets, dispatching on their representations; output is sorted ascending
+template <typename Out>
+void intersectNeighborSets(const NeighborSet &a, const NeighborSet &b, Out &out) {
+    if (a.isBitmap() && b.isBitmap()) {
+        intersectBitmaps(a.bitmap(), b.bitmap(), out);
+    } else if (a.isBitmap()) {
+        intersectArrayBitmap(b.arrayBegin(), b.arrayEnd(), a.bitmap(), out);
+    } else if (b.isBitmap()) {
+        intersectArrayBitmap(a.arrayBegin(), a.arrayEnd(), b.bitmap(), out);
+    } else {
+        intersectSortedArrays(a.arrayBegin(), a.arrayEnd(), b.arrayBegin(), b.arrayEnd(), out);
+    }
+}
+
+// Persistent compressed trees (C-trees, as in Aspen) for versioned graphs. An element is a "head"
+// when its hash has the low kCTreeChunkBits bits clear. Each head owns the non-head elements that
+// follow it (up to the next head) as a varint gap-coded chunk, and the heads form a treap whose
+// priorities are hashes too, so a set's shape depends only on its contents. Nodes are immutable:
+// an update copies the O(log n) path to the chunk it touches and shares everything else.
+constexpr uint32_t kCTreeChunkBits = 5; // Expected chunk length 32
+
+inline uint32_t ctreeHash(uint32_t x, uint32_t salt) {
+    uint64_t h = (uint64_t(x) ^ salt) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<uint32_t>(h >> 32);
+}
+inline bool ctreeIsHead(uint32_t x) { return (ctreeHash(x, 0) & ((1u << kCTreeChunkBits) - 1)) == 0; }
+inline uint64_t ctreePriority(uint32_t x) { return (uint64_t(ctreeHash(x, 0x5bd1e995)) << 32) | x; }
+
+using CTreeChunk = shared_ptr<const vector<uint8_t>>; // nullptr when empty
+
+// Gap-codes sorted values (all greater than base, or any values when base is the prefix's 0)
+CTreeChunk ctreeEncode(uint32_t base, const uint32_t *begin, const uint32_t *end) {
+    if (begin == end) return nullptr;
+    // Size the chunk exactly first so it is allocated once
+    size_t length = 0;
+    for (const uint32_t *p = begin, *previous = nullptr; p != end; previous = p++) {
+        uint32_t gap = *p - (previous ? *previous : base);
+        do {
+            ++length;
+            gap >>= 7;
+        } while (gap);
+    }
+    auto bytes = make_shared<vector<uint8_t>>(length);
+    uint8_t *out = bytes->data();
+    for (uint32_t previous = base; begin != end; previous = *begin++) {
+        uint32_t gap = *begin - previous;
+        for (; gap >= 0x80; gap >>= 7) *out++ = static_cast<uint8_t>(gap | 0x80);
+        *out++ = static_cast<uint8_t>(gap);
+    }
+    return bytes;
+}
+
+template <typename F>
+void ctreeDecode(const CTreeChunk &chunk, uint32_t base, F f) {
+    if (!chunk) return;
+    uint32_t value = base;
+    for (size_t i = 0; i < chunk->size();) {
+        uint32_t gap = 0;
+        for (int shift = 0;; shift += 7) {
+            uint8_t byte = (*chunk)[i++];
+            gap |= uint32_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        value += gap;
+        f(value);
+    }
+}
+
+struct CTreeNode {
+    uint32_t head;
+    uint32_t tailCount;
+    uint64_t size; // Elements in this subtree, heads and tails
+    CTreeChunk tail;
+    shared_ptr<const CTreeNode> left, right;
+};
+using CTreeNodePtr = shared_ptr<const CTreeNode>;
+
+inline uint64_t ctreeSize(const CTreeNodePtr &node) { return node ? node->size : 0; }
+
+CTreeNodePtr ctreeMakeNode(uint32_t head, CTreeChunk tail, uint32_t tailCount, CTreeNodePtr left, CTreeNodePtr right) {
+    uint64_t size = 1 + tailCount + ctreeSize(left) + ctreeSize(right);
+    return make_shared<const CTreeNode>(CTreeNode{head, tailCount, size, std::move(tail), std::move(left), std::move(right)});
+}
+
+// An immutable sorted set of vertex IDs; copying one is O(1)
+struct CTree {
+    CTreeChunk prefix; // Elements before the first head
+    uint32_t prefixCount = 0;
+    CTreeNodePtr root;
+
+    uint64_t size() const { return prefixCount + ctreeSize(root); }
+};
+
+// Splits a treap into keys below and above `key`; the node equal to key (if any) goes to `equal`
+void ctreeSplit(const CTreeNodePtr &node, uint32_t key, CTreeNodePtr &below, CTreeNodePtr &equal, CTreeNodePtr &above) {
+    if (!node) {
+        below = above = equal = nullptr;
+        return;
+    }
+    if (key < node->head) {
+        CTreeNodePtr leftAbove;
+        ctreeSplit(node->left, key, below, equal, leftAbove);
+        above = ctreeMakeNode(node->head, node->tail, node->tailCount, leftAbove, node->right);
+    } else if (node->head < key) {
+        CTreeNodePtr rightBelow;
+        ctreeSplit(node->right, key, rightBelow, equal, above);
+        below = ctreeMakeNode(node->head, node->tail, node->tailCount, node->left, rightBelow);
+    } else {
+        below = node->left;
+        equal = node;
+        above = node->right;
+    }
+}
+
+// Joins two treaps where every key of `a` is below every key of `b`
+CTreeNodePtr ctreeJoin(const CTreeNodePtr &a, const CTreeNodePtr &b) {
+    if (!a) return b;
+    if (!b) return a;
+    if (ctreePriority(a->head) > ctreePriority(b->head)) {
+        return ctreeMakeNode(a->head, a->tail, a->tailCount, a->left, ctreeJoin(a->right, b));
+    }
+    return ctreeMakeNode(b->head, b->tail, b->tailCount, ctreeJoin(a, b->left), b->right);
+}
+
+// The node with the greatest head <= x, or nullptr if x falls in the prefix
+const CTreeNode *ctreeOwner(const CTreeNodePtr &root, uint32_t x) {
+    const CTreeNode *owner = nullptr;
+    for (const CTreeNode *node = root.get(); node;) {
+        if (node->head <= x) {
+            owner = node;
+            node = node->right.get();
+        } else {
+            node = node->left.get();
+        }
+    }
+    return owner;
+}
+
+// Path-copies the treap, replacing the tail of the node whose head is `head`
+CTreeNodePtr ctreeReplaceTail(const CTreeNodePtr &node, uint32_t head, CTreeChunk tail, uint32_t tailCount) {
+    if (node->head == head) return ctreeMakeNode(head, std::move(tail), tailCount, node->left, node->right);
+    if (head < node->head) {
+        return ctreeMakeNode(node->head, node->tail, node->tailCount,
+                             ctreeReplaceTail(node->left, head, std::move(tail), tailCount), node->right);
+    }
+    return ctreeMakeNode(node->head, node->tail, node->tailCount, node->left,
+                         ctreeReplaceTail(node->right, head, std::move(tail), tailCount));
+}
+
+// Rewrites the chunk that owns x (the prefix, or the tail of x's owner in `root`)
+template <typename Edit>
+CTree ctreeEditChunk(const CTree &tree, const CTreeNode *owner, Edit edit) {
+    vector<uint32_t> values;
+    uint32_t base = owner ? owner->head : 0;
+    ctreeDecode(owner ? owner->tail : tree.prefix, base, [&values](uint32_t v) { values.push_back(v); });
+    edit(values);
+    CTree result = tree;
+    CTreeChunk chunk = ctreeEncode(base, values.data(), values.data() + values.size());
+    if (owner) {
+        result.root = ctreeReplaceTail(tree.root, owner->head, std::move(chunk), static_cast<uint32_t>(values.size()));
+    } else {
+        result.prefix = std::move(chunk);
+        result.prefixCount = static_cast<uint32_t>(values.size());
+    }
+    return result;
+}
+
+bool ctreeContains(const CTree &tree, uint32_t x) {
+    const CTreeNode *owner = ctreeOwner(tree.root, x);
+    if (owner && owner->head == x) return true;
+    bool found = false;
+    ctreeDecode(owner ? owner->tail : tree.prefix, owner ? owner->head : 0, [&](uint32_t v) { found |= v == x; });
+    return found;
+}
+
+CTree ctreeInsert(const CTree &tree, uint32_t x) {
+    if (ctreeContains(tree, x)) return tree;
+    if (!ctreeIsHead(x)) {
+        return ctreeEditChunk(tree, ctreeOwner(tree.root, x),
+                              [x](vector<uint32_t> &values) { values.insert(std::upper_bound(values.begin(), values.end(), x), x); });
+    }
+
+    // A new head takes over the elements above it from the chunk it lands in
+    CTreeNodePtr below, equal, above;
+    ctreeSplit(tree.root, x, below, equal, above);
+    CTree left{tree.prefix, tree.prefixCount, below};
+    vector<uint32_t> moved;
+    left = ctreeEditChunk(left, ctreeOwner(below, x), [&](vector<uint32_t> &values) {
+        auto split = std::upper_bound(values.begin(), values.end(), x);
+        moved.assign(split, values.end());
+        values.erase(split, values.end());
+    });
+    CTreeNodePtr node = ctreeMakeNode(x, ctreeEncode(x, moved.data(), moved.data() + moved.size()),
+                                      static_cast<uint32_t>(moved.size()), nullptr, nullptr);
+    return CTree{left.prefix, left.prefixCount, ctreeJoin(ctreeJoin(left.root, node), above)};
+}
+
+CTree ctreeErase(const CTree &tree, uint32_t x) {
+    if (!ctreeContains(tree, x)) return tree;
+    if (!ctreeIsHead(x)) {
+        return ctreeEditChunk(tree, ctreeOwner(tree.root, x), [x](vector<uint32_t> &values) {
+            values.erase(std::lower_bound(values.begin(), values.end(), x));
+        });
+    }
+
+    // A removed head hands its tail to the preceding chunk
+    CTreeNodePtr below, equal, above;
+    ctreeSplit(tree.root, x, below, equal, above);
+    CTree left{tree.prefix, tree.prefixCount, below};
+    left = ctreeEditChunk(left, ctreeOwner(below, x), [&](vector<uint32_t> &values) {
+        ctreeDecode(equal->tail, x, [&values](uint32_t v) { values.push_back(v); });
+    });
+    return CTree{left.prefix, left.prefixCount, ctreeJoin(left.root, above)};
+}
+
+// Builds a C-tree from sorted, distinct values in linear time (heads form a Cartesian tree by priority)
+CTree ctreeBuild(const uint32_t *begin, const uint32_t *end) {
+    CTree tree;
+    const uint32_t *firstHead = std::find_if(begin, end, ctreeIsHead);
+    tree.prefix = ctreeEncode(0, begin, firstHead);
+    tree.prefixCount = static_cast<uint32_t>(firstHead - begin);
+
+    struct Pending {
+        uint32_t head;
+        CTreeChunk tail;
+        uint32_t tailCount;
+        CTreeNodePtr left, right;
+    };
+    vector<Pending> spine; // Right spine of the tree built so far, priorities decreasing
+    auto finish = [](Pending &p) { return ctreeMakeNode(p.head, p.tail, p.tailCount, p.left, p.right); };
+    for (const uint32_t *head = firstHead; head != end;) {
+        const uint32_t *next = std::find_if(head + 1, end, ctreeIsHead);
+        Pending node{*head, ctreeEncode(*head, head + 1, next), static_cast<uint32_t>(next - head - 1), nullptr, nullptr};
+        CTreeNodePtr popped;
+        while (!spine.empty() && ctreePriority(spine.back().head) < ctreePriority(node.head)) {
+            spine.back().right = popped;
+            popped = finish(spine.back());
+            spine.pop_back();
+        }
+        node.left = popped;
+        spine.push_back(std::move(node));
+        head = next;
+    }
+    CTreeNodePtr built;
+    while (!spine.empty()) {
+        spine.back().right = built;
+        built = finish(spine.back());
+        spine.pop_back();
+    }
+    tree.root = built;
+    return tree;
+}
+
+template <typename F>
+void ctreeForEachNode(const CTreeNode *node, F &f) {
+    if (!node) return;
+    ctreeForEachNode(node->left.get(), f);
+    f(node->head);
+    ctreeDecode(node->tail, node->head, f);
+    ctreeForEachNode(node->right.get(), f);
+}
+
+// Calls f(id) for every element in ascending order
+template <typename F>
+void ctreeForEach(const CTree &tree, F f) {
+    ctreeDecode(tree.prefix, 0, f);
+    ctreeForEachNode(tree.root.get(), f);
+}
+
+// One immutable version of the friendship graph: user ID -> C-tree of friends, held in a path-copied
+// 16-ary trie. Readers keep a version alive by holding its shared_ptr; nodes no version references
+// any more are freed by reference counting.
+struct VertexTrieNode {
+    static constexpr uint32_t kBits = 4;
+    static constexpr uint32_t kFanout = 1u << kBits;
+    vector<shared_ptr<const VertexTrieNode>> children; // Interior levels
+    vector<CTree> trees;                               // Leaf level
+};
+
+struct GraphVersion {
+    uint64_t number = 0;
+    uint32_t numVertices = 0;
+    uint64_t numArcs = 0;
+    uint32_t levels = 1; // Trie depth; leaves are level 0
+    shared_ptr<const VertexTrieNode> root;
+
+    const CTree &neighbors(uint32_t v) const {
+        static const CTree empty;
+        const VertexTrieNode *node = root.get();
+        for (uint32_t level = levels - 1; node && level > 0; --level) {
+            uint32_t slot = (v >> (VertexTrieNode::kBits * level)) & (VertexTrieNode::kFanout - 1);
+            node = slot < node->children.size() ? node->children[slot].get() : nullptr;
+        }
+        uint32_t slot = v & (VertexTrieNode::kFanout - 1);
+        return node && slot < node->trees.size() ? node->trees[slot] : empty;
+    }
+    uint64_t degree(uint32_t v) const { return neighbors(v).size(); }
+};
+
+// Friendship arc change recorded for the next version; later entries for an arc win
+struct VersionArcChange {
+    uint32_t source, target;
+    bool add;
+};
+
+// Rebuilds the trie path above every changed vertex, sharing all untouched subtrees
+shared_ptr<const VertexTrieNode> assignVertexTrees(const shared_ptr<const VertexTrieNode> &node, uint32_t level,
+                                                   const pair<uint32_t, CTree> *begin, const pair<uint32_t, CTree> *end) {
+    auto copy = make_shared<VertexTrieNode>(node ? *node : VertexTrieNode());
+    const uint32_t shift = VertexTrieNode::kBits * level;
+    while (begin != end) {
+        uint32_t slot = (begin->first >> shift) & (VertexTrieNode::kFanout - 1);
+        const pair<uint32_t, CTree> *stop = begin;
+        while (stop != end && ((stop->first >> shift) & (VertexTrieNode::kFanout - 1)) == slot) ++stop;
+        if (level == 0) {
+            if (copy->trees.size() <= slot) copy->trees.resize(slot + 1);
+            copy->trees[slot] = begin->second;
+        } else {
+            if (copy->children.size() <= slot) copy->children.resize(slot + 1);
+            copy->children[slot] = assignVertexTrees(copy->children[slot], level - 1, begin, stop);
+        }
+        begin = stop;
+    }
+    return copy;
+}
+
+// Produces the next version from `base`. Changes must be sorted by (source, target), keeping their
+// original order for equal arcs; vertices are updated in parallel
+shared_ptr<const GraphVersion> commitGraphVersion(const GraphVersion &base, uint32_t numVertices,
+                                                  const vector<VersionArcChange> &changes) {
+    vector<size_t> runs;
+    for (size_t i = 0; i < changes.size(); ++i) {
+        if (i == 0 || changes[i].source != changes[i - 1].source) runs.push_back(i);
+    }
+    runs.push_back(changes.size());
+
+    vector<pair<uint32_t, CTree>> updated(runs.size() - 1);
+    vector<int64_t> arcDelta(workerCount(), 0);
+    parallelFor(updated.size(), 16, [&](size_t begin, size_t end, unsigned worker) {
+        vector<uint32_t> adds, removes;
+        for (size_t r = begin; r < end; ++r) {
+            uint32_t source = changes[runs[r]].source;
+            const CTree &before = base.neighbors(source);
+            adds.clear();
+            removes.clear();
+            for (size_t i = runs[r]; i < runs[r + 1]; ++i) {
+                if (i + 1 < runs[r + 1] && changes[i + 1].target == changes[i].target) continue; // Superseded
+                (changes[i].add ? adds : removes).push_back(changes[i].target);
+            }
+
+            CTree after;
+            if ((adds.size() + removes.size()) * 8 > before.size()) {
+                // Large change relative to the set: rebuild it in one pass
+                vector<uint32_t> merged;
+                ctreeForEach(before, [&](uint32_t v) {
+                    if (!std::binary_search(removes.begin(), removes.end(), v)) merged.push_back(v);
+                });
+                size_t middle = merged.size();
+                merged.insert(merged.end(), adds.begin(), adds.end());
+                std::inplace_merge(merged.begin(), merged.begin() + middle, merged.end());
+                merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+                after = ctreeBuild(merged.data(), merged.data() + merged.size());
+            } else {
+                after = before;
+                for (uint32_t v : removes) after = ctreeErase(after, v);
+                for (uint32_t v : adds) after = ctreeInsert(after, v);
+            }
+            arcDelta[worker] += static_cast<int64_t>(after.size()) - static_cast<int64_t>(before.size());
+            updated[r] = {source, std::move(after)};
+        }
+    });
+
+    auto next = make_shared<GraphVersion>(base);
+    next->number = base.number + 1;
+    next->numVertices = numVertices;
+    for (int64_t delta : arcDelta) next->numArcs += delta;
+    while ((uint64_t(1) << (VertexTrieNode::kBits * next->levels)) < numVertices) {
+        auto grown = make_shared<VertexTrieNode>();
+        grown->children.push_back(next->root);
+        next->root = grown;
+        ++next->levels;
+    }
+    if (!updated.empty()) {
+        next->root = assignVertexTrees(next->root, next->levels - 1, updated.data(), updated.data() + updated.size());
+    }
+    return next;
+}
+
+// Flattens a version into a CSR graph so any CSR analytics can run on it
+CSRGraph materializeVersion(const GraphVersion &version) {
+    CSRGraph g;
+    g.offsets.assign(version.numVertices + 1, 0);
+    for (uint32_t v = 0; v < version.numVertices; ++v) g.offsets[v + 1] = g.offsets[v] + version.degree(v);
+    g.neighbors.resize(g.offsets[version.numVertices]);
+    parallelFor(version.numVertices, 1024, [&](size_t begin, size_t end, unsigned) {
+        for (size_t v = begin; v < end; ++v) {
+            uint32_t *out = &g.neighbors[0] + g.offsets[v];
+            ctreeForEach(version.neighbors(static_cast<uint32_t>(v)), [&out](uint32_t u) { *out++ = u; });
+        }
+    });
+    return g;
+}
+
+// Hop distances from source within one pinned version (numeric_limits<uint32_t>::max() if unreachable)
+vector<uint32_t> versionedBFS(const GraphVersion &version, uint32_t source) {
+    const uint32_t unreached = numeric_limits<uint32_t>::max();
+    vector<uint32_t> distance(version.numVertices, unreached);
+    vector<uint32_t> frontier{source};
+    distance[source] = 0;
+    for (size_t head = 0; head < frontier.size(); ++head) {
+        uint32_t u = frontier[head];
+        ctreeForEach(version.neighbors(u), [&](uint32_t v) {
+            if (distance[v] == unreached) {
+                distance[v] = distance[u] + 1;
+                frontier.push_back(v);
+            }
+        });
+    }
+    return distance;
+}
+
+// Per-thread pool for short-lived query buffers. Blocks are recycled across queries without going
+// back to the global allocator, and no lock is shared with other threads.
+pmr::memory_resource *queryScratch() {
+    thread_local pmr::unsynchronized_pool_resource pool;
+    return &pool;
+}
+
+// Test-and-test-and-set lock for short critical sections, padded to its own cache line
+struct alignas(64) SpinLock {
+    atomic<bool> locked{false};
+
+    void lock() {
+        while (locked.exchange(true, memory_order_acquire)) {
+            while (locked.load(memory_order_relaxed)) std::this_thread::yield();
+        }
+    }
+    void unlock() { locked.store(false, memory_order_release); }
+};
+
+// Name -> user ID index: flat open-addressing hash tables in the Swiss-table style, sharded by the
+// top bits of the hash. Each shard keeps one control byte per slot (empty, or 7 more bits of the
+// name's hash) in groups of 16 that are matched with one SIMD compare, so a lookup normally reads
+// one control group and one slot before comparing the name. Inserts lock only their shard and may
+// run on many threads; lookups take no locks and must not overlap inserts.
+class NameIndex {
+public:
+    static constexpr uint32_t kMissing = numeric_limits<uint32_t>::max();
+
+    explicit NameIndex(pmr::memory_resource *resource) : resource(resource) {}
+    NameIndex(const NameIndex &) = delete;
+    NameIndex &operator=(const NameIndex &) = delete;
+    ~NameIndex() { clear(); }
+
+    static uint64_t hash(string_view name) { return std::hash<string_view>()(name) * 0x9E3779B97F4A7C15ull; }
+
+    uint32_t find(string_view name) const { return find(name, hash(name)); }
+    uint32_t find(string_view name, uint64_t h) const {
+        const Shard &shard = shards[h >> (64 - kShardBits)];
+        if (shard.capacity == 0) return kMissing;
+        const int8_t tag = static_cast<int8_t>((h >> (56 - kShardBits)) & 0x7F);
+        const size_t groupMask = shard.capacity / kGroupSize - 1;
+        for (size_t group = h & groupMask, step = 1;; group = (group + step++) & groupMask) {
+            const int8_t *control = shard.control + group * kGroupSize;
+            for (uint32_t matches = matchByte(control, tag); matches; matches &= matches - 1) {
+                const Slot &slot = shard.slots[group * kGroupSize + __builtin_ctz(matches)];
+                if (slot.length == name.size() && memcmp(slot.data, name.data(), name.size()) == 0) return slot.id;
+            }
+            if (matchByte(control, kEmpty)) return kMissing; // Probing never passes a group with a free slot
+        }
+    }
+
+    // Resolves names[i] into ids[i] (kMissing when absent). Names are hashed a block at a time and
+    // their control groups prefetched, so the block's cache misses overlap instead of queueing.
+    void lookup(const string_view *names, size_t count, uint32_t *ids) const {
+        constexpr size_t kBlock = 16;
+        uint64_t hashes[kBlock];
+        for (size_t begin = 0; begin < count; begin += kBlock) {
+            const size_t n = min(kBlock, count - begin);
+            for (size_t i = 0; i < n; ++i) {
+                hashes[i] = hash(names[begin + i]);
+                const Shard &shard = shards[hashes[i] >> (64 - kShardBits)];
+                if (shard.capacity == 0) continue;
+                const size_t group = hashes[i] & (shard.capacity / kGroupSize - 1);
+                __builtin_prefetch(shard.control + group * kGroupSize);
+                __builtin_prefetch(shard.slots + group * kGroupSize);
+            }
+            for (size_t i = 0; i < n; ++i) ids[begin + i] = find(names[begin + i], hashes[i]);
+        }
+    }
+
+    // Returns the ID of `name`, first calling create() -> (interned name, new ID) if it is absent.
+    // create() runs under the shard lock, so concurrent inserts of one name create it only once.
+    template <typename Create>
+    uint32_t insert(string_view name, Create create) {
+        const uint64_t h = hash(name);
+        Shard &shard = shards[h >> (64 - kShardBits)];
+        lock_guard<SpinLock> guard(shard.lock);
+        uint32_t id = find(name, h);
+        if (id != kMissing) return id;
+
+        pair<string_view, uint32_t> created = create();
+        if ((shard.size + 1) * 8 > shard.capacity * 7) grow(shard); // Keep load below 7/8
+        place(shard, {created.first.data(), static_cast<uint32_t>(created.first.size()), created.second}, h);
+        ++shard.size;
+        return created.second;
+    }
+
+    size_t size() const {
+        size_t total = 0;
+        for (const Shard &shard : shards) total += shard.size;
+        return total;
+    }
+
+    // Frees every table
+    void clear() {
+        for (Shard &shard : shards) {
+            if (shard.capacity) resource->deallocate(shard.control, bytesFor(shard.capacity), 16);
+            shard.control = nullptr;
+            shard.slots = nullptr;
+            shard.capacity = shard.size = 0;
+        }
+    }
+
+private:
+    static constexpr int kShardBits = 6;
+    static constexpr size_t kGroupSize = 16;
+    static constexpr int8_t kEmpty = -128;
+
+    struct Slot {
+        const char *data; // Interned name bytes
+        uint32_t length;
+        uint32_t id;
+    };
+    struct Shard {
+        SpinLock lock;
+        int8_t *control = nullptr; // `capacity` control bytes, followed in the same block by the slots
+        Slot *slots = nullptr;
+        size_t capacity = 0, size = 0; // Capacity is 0 or a power-of-two number of groups
+    };
+
+    pmr::memory_resource *resource;
+    Shard shards[size_t(1) << kShardBits];
+
+    static size_t bytesFor(size_t capacity) { return capacity + capacity * sizeof(Slot); }
+
+    // Bit i is set when control byte i of the group equals value
+    static uint32_t matchByte(const int8_t *control, int8_t value) {
+#ifdef __SSE2__
+        __m128i group = _mm_load_si128(reinterpret_cast<const __m128i *>(control));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(value))));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kGroupSize; ++i) mask |= uint32_t(control[i] == value) << i;
+        return mask;
+#endif
+    }
+
+    // Stores a slot in the first free position of its probe sequence
+    static void place(Shard &shard, const Slot &slot, uint64_t h) {
+        const size_t groupMask = shard.capacity / kGroupSize - 1;
+        for (size_t group = h & groupMask, step = 1;; group = (group + step++) & groupMask) {
+            uint32_t free = matchByte(shard.control + group * kGroupSize, kEmpty);
+            if (free) {
+                size_t index = group * kGroupSize + __builtin_ctz(free);
+                shard.control[index] = static_cast<int8_t>((h >> (56 - kShardBits)) & 0x7F);
+                shard.slots[index] = slot;
+                return;
+            }
+        }
+    }
+
+    // Doubles a shard's capacity, rehashing its names into a new block
+    void grow(Shard &shard) {
+        const size_t oldCapacity = shard.capacity;
+        int8_t *oldControl = shard.control;
+        Slot *oldSlots = shard.slots;
+
+        shard.capacity = oldCapacity ? 2 * oldCapacity : kGroupSize;
+        shard.control = static_cast<int8_t *>(resource->allocate(bytesFor(shard.capacity), 16));
+        shard.slots = reinterpret_cast<Slot *>(shard.control + shard.capacity);
+        memset(shard.control, kEmpty, shard.capacity);
+        for (size_t i = 0; i < oldCapacity; ++i) {
+            if (oldControl[i] != kEmpty) place(shard, oldSlots[i], hash(string_view(oldSlots[i].data, oldSlots[i].length)));
+        }
+        if (oldCapacity) resource->deallocate(oldControl, bytesFor(oldCapacity), 16);
+    }
+};
+
+// Blocked Bloom filter over friendships, keyed by the (lower ID, higher ID) pair. Each friendship
+// sets its probe bits inside one 512-bit block (a cache line), so a lookup costs one memory access.
+// A "no" is always right; a "maybe" must be confirmed against the friend lists. Bits cannot be
+// cleared, so removed friendships and growth past the sized capacity are counted, and the owner
+// rebuilds the filter once it has drifted too far from its target false-positive rate.
+class FriendshipFilter {
+public:
+    // Sizes the filter for `capacity` friendships at the given false-positive rate and clears it
+    void reset(size_t capacity, double falsePositiveRate) {
+        // log2(1/p) probes and log2(1/p) / ln 2 bits per friendship are optimal for a plain Bloom
+        // filter; blocking skews the load across blocks, which 20% extra bits make up for
+        const double bitsPerKey = 1.2 * -log2(falsePositiveRate) / log(2.0);
+        probes = max(1u, static_cast<uint32_t>(lround(-log2(falsePositiveRate))));
+        blockCount = max<size_t>(1, static_cast<size_t>(ceil(capacity * bitsPerKey / 512)));
+        blocks.reset(new Block[blockCount]());
+        sizedFor = capacity;
+        insertions = 0;
+        removals = 0;
+    }
+
+    // Safe to call from many threads at once
+    void insert(uint32_t a, uint32_t b) {
+        uint64_t mask[8] = {};
+        Block &block = blocks[locate(a, b, mask)];
+        for (int w = 0; w < 8; ++w) {
+            if (mask[w]) block.words[w].fetch_or(mask[w], memory_order_relaxed);
+        }
+        insertions.fetch_add(1, memory_order_relaxed);
+    }
+
+    void noteRemoval() { removals.fetch_add(1, memory_order_relaxed); }
+
+    bool mayContain(uint32_t a, uint32_t b) const {
+        uint64_t mask[8] = {};
+        const Block &block = blocks[locate(a, b, mask)];
+        for (int w = 0; w < 8; ++w) {
+            if ((block.words[w].load(memory_order_relaxed) & mask[w]) != mask[w]) return false;
+        }
+        return true;
+    }
+
+    // Over capacity, or enough removed friendships still set bits that "maybe" answers are inflated
+    bool stale() const {
+        return insertions.load(memory_order_relaxed) > sizedFor || removals.load(memory_order_relaxed) > sizedFor / 4;
+    }
+
+    size_t bytes() const { return blockCount * sizeof(Block); }
+
+private:
+    struct alignas(64) Block {
+        atomic<uint64_t> words[8];
+    };
+    unique_ptr<Block[]> blocks;
+    size_t blockCount = 0;
+    uint32_t probes = 1;
+    size_t sizedFor = 0;
+    atomic<size_t> insertions{0}, removals{0};
+
+    // The high half of the hash picks the block; the low half seeds a small LCG whose top 9 bits
+    // place the probes
+    size_t locate(uint32_t a, uint32_t b, uint64_t (&mask)[8]) const {
+        if (a > b) swap(a, b);
+        uint64_t h = ((uint64_t(a) << 32) | b) * 0x9E3779B97F4A7C15ULL;
+        h = (h ^ (h >> 31)) * 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 29;
+        uint32_t state = static_cast<uint32_t>(h);
+        for (uint32_t i = 0; i < probes; ++i) {
+            state = state * 0x9E3779B1u + 0x7F4A7C15u;
+            const uint32_t bit = state >> 23;
+            mask[bit >> 6] |= uint64_t(1) << (bit & 63);
+        }
+        return static_cast<size_t>(((h >> 32) * blockCount) >> 32);
+    }
+};
+
+// Per-vertex tables read by the similarity scorers, indexed by snapshot vertex
+struct SimilarityTables {
+    vector<uint32_t> degree;
+    vector<double> inverseDegree;    // 1 / degree (0 when isolated)
+    vector<double> inverseLogDegree; // 1 / ln(degree) (0 below degree 2)
+};
+
+// Link-prediction scorers for SocialNetwork::suggestFriendsBy. pathWeight is what one common friend
+// contributes; it is looked up once per friend, so the inner loop over friends-of-friends is a plain
+// add. score turns the summed weights into the final value given both users' degrees.
+struct MutualFriendsScore { // Number of common friends
+    static double pathWeight(const SimilarityTables &, uint32_t) { return 1.0; }
+    static double score(double sum, uint32_t, uint32_t) { return sum; }
+};
+struct JaccardScore { // Common friends over all friends of either user
+    static double pathWeight(const SimilarityTables &, uint32_t) { return 1.0; }
+    static double score(double sum, uint32_t userDegree, uint32_t candidateDegree) {
+        return sum / (userDegree + candidateDegree - sum);
+    }
+};
+struct CosineScore { // Common friends over the geometric mean of the degrees (Salton index)
+    static double pathWeight(const SimilarityTables &, uint32_t) { return 1.0; }
+    static double score(double sum, uint32_t userDegree, uint32_t candidateDegree) {
+        return sum / sqrt(double(userDegree) * candidateDegree);
+    }
+};
+struct AdamicAdarScore { // Common friends weighted by 1 / ln(degree): rare connections count more
+    static double pathWeight(const SimilarityTables &tables, uint32_t via) { return tables.inverseLogDegree[via]; }
+    static double score(double sum, uint32_t, uint32_t) { return sum; }
+};
+struct ResourceAllocationScore { // Common friends weighted by 1 / degree
+    static double pathWeight(const SimilarityTables &tables, uint32_t via) { return tables.inverseDegree[via]; }
+    static double score(double sum, uint32_t, uint32_t) { return sum; }
+};
+
+// MinHash sketches of every user's friend set, for approximate Jaccard similarity across the whole
+// network. Each user keeps kHashes minima (one per hash function), which can only shrink as friends
+// are added, so additions update a signature in place. Comparisons read just the low 8 bits of each
+// minimum (b-bit MinHash), 64 bytes per user, compared 16 at a time with SSE2. An LSH index over
+// bands of kBandRows full minima finds users likely to be similar without scanning everyone.
+class MinHashSketches {
+public:
+    static constexpr uint32_t kHashes = 64;
+    static constexpr uint32_t kBandRows = 2;
+    static constexpr uint32_t kBands = kHashes / kBandRows;
+    static constexpr uint32_t kEmpty = UINT32_MAX; // Minimum of an empty set
+
+    MinHashSketches() {
+        // Hash i of x is the top half of multipliers[i] * mix(x) + offsets[i] (multiply-shift)
+        FastRng rng(0x5eed);
+        for (uint32_t i = 0; i < kHashes; ++i) {
+            multipliers[i] = (uint64_t(rng.next()) << 32 | rng.next()) | 1;
+            offsets[i] = uint64_t(rng.next()) << 32 | rng.next();
+        }
+    }
+
+    uint32_t users() const { return static_cast<uint32_t>(codes.size() / kHashes); }
+    bool empty(uint32_t user) const { return minima[size_t(user) * kHashes] == kEmpty; }
+
+    // New users start with empty signatures
+    void resize(uint32_t count) {
+        minima.resize(size_t(count) * kHashes, kEmpty);
+        codes.resize(size_t(count) * kHashes, uint8_t(kEmpty));
+    }
+
+    void clear() {
+        vector<uint32_t>().swap(minima);
+        vector<uint8_t>().swap(codes);
+        for (vector<uint64_t> &band : bands) vector<uint64_t>().swap(band);
+    }
+
+    // Adds one element to a user's set; returns whether the signature changed
+    bool insert(uint32_t user, uint32_t element) {
+        uint32_t *row = &minima[size_t(user) * kHashes];
+        const uint64_t x = mix(element);
+        bool changed = false;
+        for (uint32_t i = 0; i < kHashes; ++i) {
+            const uint32_t h = hash(x, i);
+            if (h < row[i]) {
+                row[i] = h;
+                codes[size_t(user) * kHashes + i] = static_cast<uint8_t>(h);
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    // Whether removing element could change the user's signature (it holds one of the minima)
+    bool dependsOn(uint32_t user, uint32_t element) const {
+        const uint32_t *row = &minima[size_t(user) * kHashes];
+        const uint64_t x = mix(element);
+        for (uint32_t i = 0; i < kHashes; ++i) {
+            if (hash(x, i) == row[i]) return true;
+        }
+        return false;
+    }
+
+    // Recomputes a user's signature from scratch (after removals), with a branch-free minimum
+    void assign(uint32_t user, const NeighborSet &elements) {
+        uint32_t row[kHashes];
+        std::fill_n(row, kHashes, kEmpty);
+        elements.forEach([&](uint32_t element) {
+            const uint64_t x = mix(element);
+            for (uint32_t i = 0; i < kHashes; ++i) row[i] = min(row[i], hash(x, i));
+        });
+        for (uint32_t i = 0; i < kHashes; ++i) {
+            minima[size_t(user) * kHashes + i] = row[i];
+            codes[size_t(user) * kHashes + i] = static_cast<uint8_t>(row[i]);
+        }
+    }
+
+    // Estimated Jaccard similarity of two users' sets. Matching b-bit codes also include chance
+    // collisions (1 in 256), which are subtracted out.
+    double estimate(uint32_t a, uint32_t b) const {
+        if (empty(a) || empty(b)) return 0.0;
+        const uint8_t *x = &codes[size_t(a) * kHashes], *y = &codes[size_t(b) * kHashes];
+        uint32_t matches = 0;
+#ifdef __SSE2__
+        for (uint32_t i = 0; i < kHashes; i += 16) {
+            __m128i equal = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(x + i)),
+                                           _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + i)));
+            matches += __builtin_popcount(static_cast<uint32_t>(_mm_movemask_epi8(equal)));
+        }
+#else
+        for (uint32_t i = 0; i < kHashes; ++i) matches += x[i] == y[i];
+#endif
+        constexpr double chance = 1.0 / 256;
+        return max(0.0, (double(matches) / kHashes - chance) / (1.0 - chance));
+    }
+
+    // Rebuilds the LSH index from every signature
+    void buildIndex() {
+        parallelFor(kBands, 1, [&](size_t begin, size_t end, unsigned) {
+            for (size_t band = begin; band < end; ++band) {
+                bands[band].clear();
+                for (uint32_t user = 0; user < users(); ++user) {
+                    if (!empty(user)) bands[band].push_back(entry(bandKey(user, band), user));
+                }
+                std::sort(bands[band].begin(), bands[band].end());
+            }
+        });
+    }
+
+    // Indexes the current signatures of users whose signatures changed (sorted, without duplicates).
+    // Their old entries stay behind and are skipped by lookups until a band has more stale entries
+    // than live ones, at which point it is compacted.
+    void reindex(const vector<uint32_t> &changed) {
+        if (changed.empty()) return;
+        parallelFor(kBands, 1, [&](size_t begin, size_t end, unsigned) {
+            vector<uint64_t> added;
+            for (size_t band = begin; band < end; ++band) {
+                vector<uint64_t> &entries = bands[band];
+                added.clear();
+                for (uint32_t user : changed) {
+                    if (!empty(user)) added.push_back(entry(bandKey(user, band), user));
+                }
+                std::sort(added.begin(), added.end());
+                const size_t old = entries.size();
+                entries.insert(entries.end(), added.begin(), added.end());
+                std::inplace_merge(entries.begin(), entries.begin() + old, entries.end());
+                entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+                if (entries.size() > 2 * size_t(users())) {
+                    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                                 [&](uint64_t e) {
+                                                     const uint32_t user = static_cast<uint32_t>(e);
+                                                     return empty(user) || bandKey(user, band) != (e >> 32);
+                                                 }),
+                                  entries.end());
+                }
+            }
+        });
+    }
+
+    // Appends every user sharing at least one band with user (possibly more than once)
+    void candidates(uint32_t user, vector<uint32_t> &out) const {
+        if (empty(user)) return;
+        for (uint32_t band = 0; band < kBands; ++band) {
+            const uint32_t key = bandKey(user, band);
+            const vector<uint64_t> &entries = bands[band];
+            for (auto e = std::lower_bound(entries.begin(), entries.end(), entry(key, 0));
+                 e != entries.end() && (*e >> 32) == key; ++e) {
+                const uint32_t other = static_cast<uint32_t>(*e);
+                if (other != user && bandKey(other, band) == key) out.push_back(other); // Skip stale entries
+            }
+        }
+    }
+
+private:
+    vector<uint32_t> minima; // kHashes per user, by user ID
+    vector<uint8_t> codes;   // Low 8 bits of each minimum
+    vector<uint64_t> bands[kBands]; // Sorted (band key << 32 | user ID)
+    uint64_t multipliers[kHashes], offsets[kHashes];
+
+    static uint64_t mix(uint32_t x) {
+        uint64_t z = (uint64_t(x) + 1) * 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        return z ^ (z >> 31);
+    }
+    uint32_t hash(uint64_t x, uint32_t i) const { return static_cast<uint32_t>((multipliers[i] * x + offsets[i]) >> 32); }
+    static_assert(kBandRows == 2, "bandKey hashes two minima");
+    uint32_t bandKey(uint32_t user, size_t band) const {
+        const uint32_t *row = &minima[size_t(user) * kHashes + band * kBandRows];
+        return static_cast<uint32_t>(mix(row[0] ^ (row[1] * 0x9E3779B1u)) >> 32);
+    }
+    static uint64_t entry(uint32_t key, uint32_t user) { return uint64_t(key) << 32 | user; }
+};
+
+// One user returned by SocialNetwork::searchUsers / fuzzySearchUsers
+struct UserSearchHit {
+    string name;
+    uint32_t degree;
+    int distance; // Hops from the searching user; -1 when not ranked by distance or farther than the search radius
+    int edits;    // Edit distance to the query (0 for prefix matches)
+};
+
+// A user's neighborhood as a standalone graph over local IDs: 0 is the center, then the users at
+// 1 hop, then 2 hops, and so on
+struct EgoNetwork {
+    CSRGraph graph;       // Friendships among the included users, in local IDs
+    vector<string> names; // Local ID -> user name
+    vector<uint32_t> hops; // Local ID -> BFS layer it was reached in (its distance unless sampling skipped a shorter path)
+};
+
+// How two users are connected: their distance, how many distinct shortest paths join them, and a
+// few of those paths drawn at random
+struct ShortestPathCount {
+    int distance = -1;            // Hops, -1 when not connected
+    PathCounter count = 0;        // Number of shortest paths, kPathCounterMax if it does not fit
+    vector<list<string>> samples; // Distinct sampled shortest paths
+
+    string countString() const {
+        if (count == kPathCounterMax) return "more than 3.4e38";
+        string digits;
+        for (PathCounter rest = count; rest > 0 || digits.empty(); rest /= 10) digits.push_back(char('0' + int(rest % 10)));
+        return string(digits.rbegin(), digits.rend());
+    }
+};
+
+// How search results are ordered (fuzzy matches are ordered by edit distance first)
+enum class SearchRanking {
+    Degree,  // Most-connected users first
+    Distance // Closest to the searching user first, then by degree
+};
+
+// Search index over the interned user names: user IDs in name order (4 bytes per user, the names
+// themselves are not copied). Users sharing a prefix form one contiguous rank range. Degrees are
+// kept by rank with a per-block maximum, so the best-connected users of a range come out of a heap
+// over blocks without scanning the whole range.
+class NameSearchIndex {
+public:
+    static constexpr uint32_t kBlockSize = 64;
+
+    vector<uint32_t> byName; // Rank -> user ID
+    vector<uint32_t> rankOf; // User ID -> rank
+    vector<uint32_t> degrees; // By rank
+    vector<uint32_t> blockMax; // Largest degree in each block of kBlockSize ranks
+
+    // Adds users [byName.size(), count) to the name order; new users are sorted and merged in
+    void addUsers(const string_view *names, uint32_t count) {
+        auto byString = [names](uint32_t a, uint32_t b) { return names[a] < names[b]; };
+        const size_t old = byName.size();
+        for (uint32_t id = static_cast<uint32_t>(old); id < count; ++id) byName.push_back(id);
+        std::sort(byName.begin() + old, byName.end(), byString);
+        std::inplace_merge(byName.begin(), byName.begin() + old, byName.end(), byString);
+        rankOf.resize(count);
+        for (uint32_t rank = 0; rank < count; ++rank) rankOf[byName[rank]] = rank;
+    }
+
+    template <typename DegreeOf>
+    void refreshDegrees(DegreeOf degreeOf) {
+        degrees.resize(byName.size());
+        blockMax.assign((byName.size() + kBlockSize - 1) / kBlockSize, 0);
+        for (uint32_t rank = 0; rank < byName.size(); ++rank) {
+            degrees[rank] = degreeOf(byName[rank]);
+            blockMax[rank / kBlockSize] = max(blockMax[rank / kBlockSize], degrees[rank]);
+        }
+    }
+
+    // Ranks [first, second) of the names starting with prefix
+    pair<uint32_t, uint32_t> prefixRange(const string_view *names, string_view prefix) const {
+        auto first = std::partition_point(byName.begin(), byName.end(),
+                                          [&](uint32_t id) { return names[id] < prefix; });
+        auto last = std::partition_point(first, byName.end(),
+                                         [&](uint32_t id) { return names[id].substr(0, prefix.size()) == prefix; });
+        return {static_cast<uint32_t>(first - byName.begin()), static_cast<uint32_t>(last - byName.begin())};
+    }
+
+    // Appends (rank, edits) for every name within maxEdits of query. Walks the names in order as if
+    // they were a trie: each name reuses the Levenshtein rows of the prefix it shares with the last
+    // one, and once every entry of a row exceeds maxEdits, all names with that prefix are skipped.
+    void fuzzyMatches(const string_view *names, string_view query, int maxEdits, vector<pair<uint32_t, int>> &out) const {
+        const size_t width = query.size() + 1;
+        vector<int> rows(width); // rows[d * width + j]: distance between the first d bytes of `current` and query[0, j)
+        for (size_t j = 0; j < width; ++j) rows[j] = static_cast<int>(j);
+        string_view current;
+        size_t valid = 0; // Rows 0..valid describe prefixes of `current`
+
+        for (uint32_t rank = 0; rank < byName.size();) {
+            const string_view name = names[byName[rank]];
+            size_t depth = 0;
+            while (depth < min(valid, name.size()) && depth < current.size() && current[depth] == name[depth]) ++depth;
+            current = name;
+
+            bool pruned = false;
+            for (; depth < name.size(); ++depth) {
+                if (rows.size() < (depth + 2) * width) rows.resize((depth + 2) * width);
+                const int *prev = &rows[depth * width];
+                int *row = &rows[(depth + 1) * width];
+                row[0] = static_cast<int>(depth + 1);
+                int best = row[0];
+                for (size_t j = 1; j < width; ++j) {
+                    row[j] = min({prev[j] + 1, row[j - 1] + 1, prev[j - 1] + (name[depth] != query[j - 1])});
+                    best = min(best, row[j]);
+                }
+                if (best > maxEdits) {
+                    pruned = true;
+                    ++depth;
+                    break;
+                }
+            }
+            valid = depth;
+            if (pruned) {
+                const string_view stem = name.substr(0, depth);
+                rank = static_cast<uint32_t>(std::partition_point(byName.begin() + rank, byName.end(), [&](uint32_t id) {
+                                                 return names[id].substr(0, stem.size()) == stem;
+                                             }) - byName.begin());
+                continue;
+            }
+            const int edits = rows[depth * width + query.size()];
+            if (edits <= maxEdits) out.emplace_back(rank, edits);
+            ++rank;
+        }
+    }
+
+    // Up to `limit` ranks in [first, last) by degree (descending), ties in name order, skipping
+    // ranks for which skip(rank) holds
+    template <typename Skip>
+    vector<uint32_t> topByDegree(uint32_t first, uint32_t last, size_t limit, Skip skip) const {
+        // Heap entries are whole blocks (keyed by their maximum) or single ranks; a block is expanded
+        // before any rank of equal degree is emitted, which keeps ties in rank (= name) order
+        struct Entry {
+            uint32_t degree;
+            bool isRank;
+            uint32_t index;
+            bool operator<(const Entry &other) const {
+                if (degree != other.degree) return degree < other.degree;
+                if (isRank != other.isRank) return isRank;
+                return index > other.index;
+            }
+        };
+        vector<Entry> heap;
+        for (uint32_t rank = first; rank < last;) {
+            const uint32_t block = rank / kBlockSize;
+            if (rank % kBlockSize == 0 && rank + kBlockSize <= last) {
+                heap.push_back({blockMax[block], false, block});
+                rank += kBlockSize;
+            } else {
+                heap.push_back({degrees[rank], true, rank});
+                ++rank;
+            }
+        }
+        std::make_heap(heap.begin(), heap.end());
+
+        vector<uint32_t> top;
+        while (!heap.empty() && top.size() < limit) {
+            std::pop_heap(heap.begin(), heap.end());
+            Entry entry = heap.back();
+            heap.pop_back();
+            if (entry.isRank) {
+                if (!skip(entry.index)) top.push_back(entry.index);
+                continue;
+            }
+            for (uint32_t rank = entry.index * kBlockSize; rank < (entry.index + 1) * kBlockSize; ++rank) {
+                heap.push_back({degrees[rank], true, rank});
+                std::push_heap(heap.begin(), heap.end());
+            }
+        }
+        return top;
+    }
+
+    void clear() {
+        byName.clear();
+        rankOf.clear();
+        degrees.clear();
+        blockMax.clear();
+    }
+};
+
+// One friendship mutation, applied by SocialNetwork::updateFriendship or in a batch by applyBatch
+struct EdgeUpdate {
+    enum class Kind : uint8_t { Add, Remove };
+
+    string user1, user2;
+    Kind kind = Kind::Add;
+    float weight = 1.0f; // Tie strength for additions
+    int64_t timestamp = 0; // Creation time for additions; re-adding an existing friendship keeps its time
+};
+
+// Outcome of one EdgeUpdate, as if the batch had been applied one update at a time in order
+enum class UpdateStatus : uint8_t {
+    Applied,     // The friendship was added or removed
+    NoChange,    // Already friends (add; the weight is still updated) or not friends (remove)
+    UserNotFound // One or both users do not exist
+};
+
+// Community detection algorithms offered by SocialNetwork::detectCommunities
+enum class CommunityMethod {
+    LabelPropagation, // Fast, lower quality
+    Louvain           // Slower, optimizes modularity
+};
+
+// Value types of user attribute columns
+enum class AttributeType : uint8_t {
+    Int,    // 64-bit integer, e.g. age or signup year
+    String, // Dictionary-encoded: each user stores a 32-bit code into the column's dictionary
+    Flag    // One bit per user, e.g. a privacy setting
+};
+
+// Predicate over user attributes: comparisons combined with &, | and ~. A comparison never matches
+// a user whose value is null, and ~ complements the whole match set. The default filter matches
+// every user.
+class UserFilter {
+public:
+    enum class Op : uint8_t { Equals, Between, IsSet, NotNull, And, Or, Not };
+
+    struct Node {
+        Op op;
+        string attribute;
+        string text;               // Equals: the value, on a string column
+        int64_t low = 0, high = 0; // Between: inclusive range, on an integer column
+        shared_ptr<const Node> left, right; // Operands of And, Or and Not (nullptr matches everyone)
+
+        explicit Node(Op op, string attribute = string()) : op(op), attribute(std::move(attribute)) {}
+    };
+
+    UserFilter() = default;
+
+    static UserFilter equals(const string &attribute, const string &value) {
+        Node node(Op::Equals, attribute);
+        node.text = value;
+        return UserFilter(std::move(node));
+    }
+    static UserFilter equals(const string &attribute, int64_t value) { return between(attribute, value, value); }
+    static UserFilter between(const string &attribute, int64_t low, int64_t high) {
+        Node node(Op::Between, attribute);
+        node.low = low;
+        node.high = high;
+        return UserFilter(std::move(node));
+    }
+    static UserFilter isSet(const string &attribute) { return UserFilter(Node(Op::IsSet, attribute)); }
+    static UserFilter notNull(const string &attribute) { return UserFilter(Node(Op::NotNull, attribute)); }
+
+    friend UserFilter operator&(const UserFilter &a, const UserFilter &b) { return combine(Op::And, a, b); }
+    friend UserFilter operator|(const UserFilter &a, const UserFilter &b) { return combine(Op::Or, a, b); }
+    friend UserFilter operator~(const UserFilter &a) { return combine(Op::Not, a, UserFilter()); }
+
+    bool matchesAll() const { return !root; }
+    const Node *node() const { return root.get(); }
+
+private:
+    shared_ptr<const Node> root;
+
+    explicit UserFilter(Node node) : root(make_shared<const Node>(std::move(node))) {}
+    static UserFilter combine(Op op, const UserFilter &a, const UserFilter &b) {
+        if (op == Op::And && (a.matchesAll() || b.matchesAll())) return a.matchesAll() ? b : a;
+        if (op == Op::Or && (a.matchesAll() || b.matchesAll())) return UserFilter();
+        Node node(op);
+        node.left = a.root;
+        node.right = b.root;
+        return UserFilter(std::move(node));
+    }
+};
+
+// Columnar per-user property store. Each column is a fixed-width array indexed by user ID with a
+// null bitmap beside it: integers as int64_t, strings as codes into a per-column dictionary, and
+// flags as a bitmap. Columns grow on write; users past a column's end are null.
+class AttributeStore {
+public:
+    struct Column {
+        AttributeType type;
+        vector<int64_t> ints;    // Int
+        vector<uint32_t> codes;  // String
+        vector<string> dictionary;
+        unordered_map<string, uint32_t> dictionaryCodes;
+        vector<uint64_t> flags;   // Flag values, bit per user
+        vector<uint64_t> present; // Null bitmap: bit set when the user has a value
+        size_t rows = 0;          // Users covered by the arrays above
+    };
+
+    // Adds an empty column; false if the name is already taken by a column of another type
+    bool defineColumn(const string &name, AttributeType type) {
+        auto it = columns.find(name);
+        if (it != columns.end()) return it->second.type == type;
+        columns[name].type = type;
+        return true;
+    }
+
+    const Column *findColumn(const string &name) const {
+        auto it = columns.find(name);
+        return it == columns.end() ? nullptr : &it->second;
+    }
+    Column *findColumn(const string &name) {
+        auto it = columns.find(name);
+        return it == columns.end() ? nullptr : &it->second;
+    }
+
+    static void setInt(Column &column, uint32_t user, int64_t value) {
+        cover(column, user);
+        column.ints[user] = value;
+        setBit(column.present, user, true);
+    }
+    static void setString(Column &column, uint32_t user, const string &value) {
+        cover(column, user);
+        auto code = column.dictionaryCodes.emplace(value, static_cast<uint32_t>(column.dictionary.size()));
+        if (code.second) column.dictionary.push_back(value);
+        column.codes[user] = code.first->second;
+        setBit(column.present, user, true);
+    }
+    static void setFlag(Column &column, uint32_t user, bool value) {
+        cover(column, user);
+        setBit(column.flags, user, value);
+        setBit(column.present, user, true);
+    }
+    static void setNull(Column &column, uint32_t user) {
+        if (user < column.rows) setBit(column.present, user, false);
+    }
+
+    // Drops every value but keeps the column definitions
+    void clearValues() {
+        for (auto &entry : columns) {
+            Column empty;
+            empty.type = entry.second.type;
+            entry.second = std::move(empty);
+        }
+    }
+
+    // Checks that every attribute the filter names exists with a compatible type; on failure
+    // returns false and the offending attribute
+    bool validate(const UserFilter::Node *node, string &badAttribute) const {
+        if (!node) return true;
+        if (node->op == UserFilter::Op::And || node->op == UserFilter::Op::Or || node->op == UserFilter::Op::Not) {
+            return validate(node->left.get(), badAttribute) && validate(node->right.get(), badAttribute);
+        }
+        const Column *column = findColumn(node->attribute);
+        bool ok = column != nullptr;
+        if (ok && node->op == UserFilter::Op::Equals) ok = column->type == AttributeType::String;
+        if (ok && node->op == UserFilter::Op::Between) ok = column->type == AttributeType::Int;
+        if (ok && node->op == UserFilter::Op::IsSet) ok = column->type == AttributeType::Flag;
+        if (!ok) badAttribute = node->attribute;
+        return ok;
+    }
+
+    // Evaluates a validated filter for users [0, users) into a match bitmap (bit per user), one
+    // column at a time and 64 users per word
+    vector<uint64_t> evaluate(const UserFilter::Node *node, size_t users) const {
+        const size_t words = (users + 63) / 64;
+        vector<uint64_t> matches(words, ~uint64_t(0));
+        if (!node) {
+            if (users % 64) matches.back() = (uint64_t(1) << (users % 64)) - 1;
+            return matches;
+        }
+        switch (node->op) {
+        case UserFilter::Op::And:
+        case UserFilter::Op::Or: {
+            matches = evaluate(node->left.get(), users);
+            vector<uint64_t> other = evaluate(node->right.get(), users);
+            for (size_t w = 0; w < words; ++w) {
+                matches[w] = node->op == UserFilter::Op::And ? matches[w] & other[w] : matches[w] | other[w];
+            }
+            return matches;
+        }
+        case UserFilter::Op::Not:
+            matches = evaluate(node->left.get(), users);
+            for (uint64_t &word : matches) word = ~word;
+            if (users % 64) matches.back() &= (uint64_t(1) << (users % 64)) - 1;
+            return matches;
+        default:
+            break;
+        }
+
+        const Column &column = *findColumn(node->attribute);
+        const size_t rows = min(users, column.rows);
+        if (node->op == UserFilter::Op::Equals) {
+            auto code = column.dictionaryCodes.find(node->text);
+            const uint32_t target = code == column.dictionaryCodes.end() ? numeric_limits<uint32_t>::max() : code->second;
+            compareRows(column, rows, matches, [&](size_t i) { return column.codes[i] == target; });
+        } else if (node->op == UserFilter::Op::Between) {
+            const int64_t low = node->low, high = node->high;
+            compareRows(column, rows, matches, [&](size_t i) { return low <= column.ints[i] && column.ints[i] <= high; });
+        } else {
+            for (size_t w = 0; w < words; ++w) {
+                uint64_t bits = w < column.present.size() ? column.present[w] : 0;
+                if (node->op == UserFilter::Op::IsSet) bits &= w < column.flags.size() ? column.flags[w] : 0;
+                matches[w] = bits;
+            }
+            if (users % 64) matches.back() &= (uint64_t(1) << (users % 64)) - 1; // Rows past `users`
+        }
+        return matches;
+    }
+
+    // Evaluates a validated filter for a single user; cheaper than evaluate() when only a few users
+    // are tested
+    bool matches(const UserFilter::Node *node, uint32_t user) const {
+        if (!node) return true;
+        switch (node->op) {
+        case UserFilter::Op::And: return matches(node->left.get(), user) && matches(node->right.get(), user);
+        case UserFilter::Op::Or: return matches(node->left.get(), user) || matches(node->right.get(), user);
+        case UserFilter::Op::Not: return !matches(node->left.get(), user);
+        default: break;
+        }
+        const Column &column = *findColumn(node->attribute);
+        if (user >= column.rows || !testBit(column.present, user)) return false;
+        switch (node->op) {
+        case UserFilter::Op::Equals: return column.dictionary[column.codes[user]] == node->text;
+        case UserFilter::Op::Between: return node->low <= column.ints[user] && column.ints[user] <= node->high;
+        case UserFilter::Op::IsSet: return testBit(column.flags, user);
+        default: return true; // NotNull
+        }
+    }
+
+    static bool testBit(const vector<uint64_t> &bits, size_t i) { return (bits[i >> 6] >> (i & 63)) & 1; }
+
+private:
+    unordered_map<string, Column> columns;
+
+    static void setBit(vector<uint64_t> &bits, size_t i, bool value) {
+        if (value) {
+            bits[i >> 6] |= uint64_t(1) << (i & 63);
+        } else {
+            bits[i >> 6] &= ~(uint64_t(1) << (i & 63));
+        }
+    }
+
+    // Extends the column's arrays (geometrically) so that `user` has a row
+    static void cover(Column &column, uint32_t user) {
+        if (user < column.rows) return;
+        column.rows = max<size_t>(user + 1, 2 * column.rows);
+        if (column.type == AttributeType::Int) column.ints.resize(column.rows);
+        if (column.type == AttributeType::String) column.codes.resize(column.rows);
+        if (column.type == AttributeType::Flag) column.flags.resize((column.rows + 63) / 64);
+        column.present.resize((column.rows + 63) / 64);
+    }
+
+    // Packs test(i) for the column's rows into 64-bit words, masked by the null bitmap. The inner loop
+    // is branch-free so the compiler can vectorize the comparisons.
+    template <typename Test>
+    static void compareRows(const Column &column, size_t rows, vector<uint64_t> &matches, Test test) {
+        for (size_t w = 0; w < matches.size(); ++w) {
+            const size_t begin = w * 64, end = min(rows, begin + 64);
+            uint64_t bits = 0;
+            for (size_t i = begin; i < end; ++i) bits |= uint64_t(test(i)) << (i - begin);
+            matches[w] = begin < rows ? bits & column.present[w] : 0;
+        }
+    }
+};
+
+// Class representing a social network as an adjacency list graph
+class SocialNetwork {
+private:
+    // The mutable graph allocates from these: friend lists and the name index from a pool, and the
+    // name bytes from a monotonic arena. clear() and the destructor return memory in bulk. The pool
+    // keeps per-thread free lists, so concurrent friendship updates do not serialize on it.
+    pmr::synchronized_pool_resource graphPool;
+    pmr::monotonic_buffer_resource nameArena{&graphPool};
+
+    // Users get integer IDs in insertion order. The CSR snapshot may renumber them for locality,
+    // so snapshot vertices are translated through snapshotOrder / snapshotVertex.
+    NameIndex userIds{&graphPool};
+    mutex userTableMutex;                           // Serializes ID allocation in concurrent addUser calls
+    pmr::vector<string_view> userNames{&graphPool}; // Interned in nameArena
+    pmr::vector<NeighborSet> adjacency{&graphPool}; // Adjacency list representation: friends of each user, by user ID
+    CSRGraph snapshot;
+    atomic<bool> snapshotValid{false};
+    ReorderStrategy reorderStrategy = ReorderStrategy::None;
+    vector<uint32_t> snapshotOrder;  // Snapshot vertex -> user ID
+    vector<uint32_t> snapshotVertex; // User ID -> snapshot vertex
+    vector<int> mutualCountScratch;  // Per-vertex counters reused by suggestFriends
+    PathSearchWorkspace pathWorkspace; // Reused by every spur search of kShortestPaths
+    pmr::map<pair<uint32_t, uint32_t>, float> edgeWeights{&graphPool}; // Non-unit friendship weights, keyed by (lower ID, higher ID)
+    pmr::map<pair<uint32_t, uint32_t>, int64_t> edgeTimes{&graphPool}; // Non-zero friendship creation times, same keys
+    mutex edgeAttributesMutex;          // Guards edgeWeights and edgeTimes during concurrent updateFriendship calls
+    atomic<bool> hasEdgeWeights{false}; // Let default (unit weight, time 0) updates skip the mutex while
+    atomic<bool> hasEdgeTimes{false};   // no weights or times exist
+    AttributeStore attributes;          // Per-user columns, indexed by user ID
+
+    // Striped per-user locks serializing concurrent updates to the same friend lists
+    static constexpr size_t kLockStripes = 1024;
+    SpinLock userLocks[kLockStripes];
+
+    // MVCC: immutable graph versions that share structure (see enableVersioning). Friendship changes
+    // are logged per lock stripe and folded into a new version by commitVersion.
+    bool versioningEnabled = false;
+    mutex versionCommitMutex;
+    shared_ptr<const GraphVersion> latestVersion; // Accessed with atomic_load / atomic_store
+    vector<VersionArcChange> pendingVersionChanges[kLockStripes]; // Guarded by the matching userLocks stripe
+    AliasTables aliasTables;
+    bool aliasTablesValid = false;
+    vector<uint32_t> coreNumberCache;
+    bool coreNumbersValid = false;
+    NameSearchIndex searchIndex;
+    bool searchDegreesValid = false;
+    SimilarityTables similarityTables;
+    bool similarityTablesValid = false;
+    vector<double> similarityScratch; // Per-vertex score sums reused by suggestFriendsBy
+
+    // MinHash sketches, built by the first approximate-similarity query and then maintained by every
+    // friendship update. Users whose signatures changed are logged per lock stripe and reindexed in
+    // the LSH bands before the next query.
+    bool sketchesEnabled = false;
+    MinHashSketches sketches;
+    vector<uint32_t> pendingSketchUsers[kLockStripes]; // Guarded by the matching userLocks stripe
+
+    // Optional Bloom filter answering most "are they friends?" checks without the friend lists (see
+    // enableFriendshipFilter). Updates add to it; queries rebuild it once it has gone stale.
+    bool friendshipFilterEnabled = false;
+    double friendshipFilterRate = 0.01;
+    FriendshipFilter friendshipFilter;
+
+    const vector<uint32_t> &cachedCoreNumbers();
+    const NameSearchIndex &cachedSearchIndex();
+    const SimilarityTables &cachedSimilarityTables();
+    const MinHashSketches &cachedSketches();
+    const FriendshipFilter *cachedFriendshipFilter();
+    void rebuildFriendshipFilter();
+    // Exact friendship test by user ID, skipping the friend list when the filter rules it out
+    bool isFriend(const FriendshipFilter *filter, uint32_t id1, uint32_t id2) const {
+        return (!filter || filter->mayContain(id1, id2)) && adjacency[id1].contains(id2);
+    }
+    vector<pair<uint32_t, int>> nearbyMatches(uint32_t source, uint32_t first, uint32_t last, const vector<uint32_t> *ranks,
+                                              size_t enough);
+    UserSearchHit searchHit(uint32_t rank, int distance, int edits) const;
+
+    bool findVertex(const string &userName, uint32_t &vertex) const;
+    AttributeStore::Column *attributeColumn(const string &userName, const string &attribute, uint32_t &user);
+    bool checkFilter(const UserFilter &filter) const;
+    vector<uint64_t> filterBitmap(const UserFilter &filter, size_t probes) const;
+    bool passesFilter(const UserFilter &filter, const vector<uint64_t> &bitmap, uint32_t id) const {
+        if (filter.matchesAll()) return true;
+        return bitmap.empty() ? attributes.matches(filter.node(), id) : AttributeStore::testBit(bitmap, id);
+    }
+    string_view vertexName(uint32_t vertex) const { return userNames[snapshotOrder[vertex]]; }
+
+public:
+    SocialNetwork() = default;
+    SocialNetwork(const SocialNetwork &) = delete;
+    SocialNetwork &operator=(const SocialNetwork &) = delete;
+
+    void addUser(const string &userName);
+    vector<uint32_t> lookupIds(const vector<string_view> &names) const;
+    void clear();
+    void addFriendship(const string &user1, const string &user2, float weight = 1.0f, int64_t timestamp = 0);
+    void removeFriendship(const string &user1, const string &user2);
+    UpdateStatus updateFriendship(const EdgeUpdate &update);
+    vector<UpdateStatus> applyBatch(const vector<EdgeUpdate> &updates);
+
+    // Versioned (MVCC) reads
+    void enableVersioning();
+    void commitVersion();
+    shared_ptr<const GraphVersion> pinVersion() const;
+    set<string> getFriends(const GraphVersion &version, const string &userName) const;
+    vector<pair<string, double>> pageRank(const GraphVersion &version, double damping = 0.85, double tolerance = 1e-10,
+                                          int maxIterations = 100) const;
+    set<string> getFriends(const string &userName) const;
+    void enableFriendshipFilter(double falsePositiveRate = 0.01);
+    bool areFriends(const string &user1, const string &user2);
+    void printGraph() const;
+
+    // User attributes, stored column-wise, and filtered queries (not safe concurrently with updates)
+    void defineAttribute(const string &attribute, AttributeType type);
+    void setAttribute(const string &userName, const string &attribute, int64_t value);
+    void setAttribute(const string &userName, const string &attribute, const string &value);
+    void setFlag(const string &userName, const string &attribute, bool value);
+    void clearAttribute(const string &userName, const string &attribute);
+    set<string> getFriends(const string &userName, const UserFilter &filter) const;
+
+    // Advanced graph operations
+    set<string> getMutualFriends(const string &user1, const string &user2, const TimeWindow &window = TimeWindow());
+    vector<pair<string, int>> suggestFriends(const string &userName, uint32_t minCoreNumber = 0,
+                                             const TimeWindow &window = TimeWindow(),
+                                             const UserFilter &filter = UserFilter());
+    pair<int, list<string>> shortestPathBFS(const string &startUser, const string &endUser,
+                                            const TimeWindow &window = TimeWindow(),
+                                            const UserFilter &filter = UserFilter());
+    pair<int, list<string>> shortestPathDijkstra(const string &startUser, const string &endUser);
+    vector<list<string>> kShortestPaths(const string &startUser, const string &endUser, size_t k);
+    ShortestPathCount countShortestPaths(const string &startUser, const string &endUser, size_t samples = 0);
+
+    // CSR-based analytics
+    void setReorderStrategy(ReorderStrategy strategy);
+    const CSRGraph &getSnapshot();
+    CompressedCSRGraph getCompressedSnapshot();
+    WebGraphCompressed getWebGraphSnapshot();
+    vector<pair<string, double>> pageRank(double damping = 0.85, double tolerance = 1e-10, int maxIterations = 100);
+    vector<pair<string, double>> suggestFriendsPPR(const string &userName, size_t k, double epsilon = 1e-6);
+    template <typename Scorer>
+    vector<pair<string, double>> suggestFriendsBy(const string &userName, size_t k);
+    vector<pair<string, double>> suggestFriendsRandomWalk(const string &userName, size_t k, size_t walkBudget = 100000,
+                                                          double restartProbability = 0.15);
+    pair<double, vector<pair<string, double>>> betweennessCentrality(size_t pivots = 0, double confidence = 0.95);
+    vector<double> neighborhoodFunction(int maxHops = 32, int log2Registers = 6);
+    vector<pair<string, double>> reachEstimates(int hops, int log2Registers = 6);
+    vector<uint32_t> hopCounts(const string &userName);
+    double effectiveDiameter(double quantile = 0.9, int log2Registers = 6);
+    vector<pair<string, uint32_t>> coreNumbers();
+    CSRSubgraph kCoreSubgraph(uint32_t k);
+    EgoNetwork egoNetwork(const string &userName, uint32_t radius, size_t maxNodes);
+
+    // Approximate friend-set (Jaccard) similarity from MinHash sketches, for any two users
+    double estimateSimilarity(const string &user1, const string &user2);
+    vector<pair<string, double>> similarUsers(const string &userName, size_t k);
+    pair<double, vector<pair<string, uint32_t>>> detectCommunities(CommunityMethod method = CommunityMethod::Louvain);
+
+    // Name search: prefix autocomplete and typo-tolerant lookup
+    vector<UserSearchHit> searchUsers(const string &prefix, size_t limit, SearchRanking ranking = SearchRanking::Degree,
+                                      const string &searcher = "");
+    vector<UserSearchHit> fuzzySearchUsers(const string &query, int maxEdits, size_t limit,
+                                           SearchRanking ranking = SearchRanking::Degree, const string &searcher = "");
+};
+
+// Adds a new user to the social network. Several threads may add users at once (but not while
+// other methods run): duplicate checks lock one shard of the name index, and only assigning the ID
+// is serialized.
+void SocialNetwork::addUser(const string &userName) {
+    bool added = false;
+    userIds.insert(userName, [&]() {
+        lock_guard<mutex> guard(userTableMutex);
+        // Intern the name so the index and the ID table share one copy
+        char *bytes = static_cast<char *>(nameArena.allocate(userName.size(), 1));
+        memcpy(bytes, userName.data(), userName.size());
+        string_view name(bytes, userName.size());
+        uint32_t id = static_cast<uint32_t>(userNames.size());
+        userNames.push_back(name);
+        adjacency.emplace_back(); // Create an empty set for the new user's friends
+        if (sketchesEnabled) sketches.resize(id + 1);
+        added = true;
+        return make_pair(name, id);
+    });
+    if (added) {
+        snapshotValid = false;
+        cout << "User '" << userName << "' added." << endl;
+    }
+}
+
+// Resolves user names to user IDs (insertion order, as used by graph versions); unknown names map
+// to NameIndex::kMissing
+vector<uint32_t> SocialNetwork::lookupIds(const vector<string_view> &names) const {
+    vector<uint32_t> ids(names.size());
+    userIds.lookup(names.data(), names.size(), ids.data());
+    return ids;
+}
+
+// Removes every user and friendship. The containers are dropped first so that the pool and name
+// arena can then release all of their memory at once (no per-node frees to the global heap).
+void SocialNetwork::clear() {
+    userIds.clear();
+    pmr::vector<string_view>(&graphPool).swap(userNames);
+    pmr::vector<NeighborSet>(&graphPool).swap(adjacency);
+    pmr::map<pair<uint32_t, uint32_t>, float>(&graphPool).swap(edgeWeights);
+    pmr::map<pair<uint32_t, uint32_t>, int64_t>(&graphPool).swap(edgeTimes);
+    hasEdgeWeights = false;
+    hasEdgeTimes = false;
+    attributes.clearValues();
+    versioningEnabled = false;
+    atomic_store(&latestVersion, shared_ptr<const GraphVersion>());
+    for (vector<VersionArcChange> &pending : pendingVersionChanges) pending.clear();
+    sketchesEnabled = false;
+    sketches.clear();
+    for (vector<uint32_t> &pending : pendingSketchUsers) pending.clear();
+    friendshipFilterEnabled = false;
+    friendshipFilter.reset(0, friendshipFilterRate);
+    nameArena.release();
+    graphPool.release();
+
+    snapshot = CSRGraph();
+    snapshotValid = false;
+    aliasTablesValid = false;
+    coreNumbersValid = false;
+    searchIndex.clear();
+}
+
+// Creates a bidirectional friendship between two users, optionally weighted by tie strength and
+// stamped with its creation time
+void SocialNetwork::addFriendship(const string &user1, const string &user2, float weight, int64_t timestamp) {
+    if (updateFriendship({user1, user2, EdgeUpdate::Kind::Add, weight, timestamp}) != UpdateStatus::UserNotFound) {
+        cout << "Friendship added between '" << user1 << "' and '" << user2 << "'." << endl;
+    } else {
+        cout << "One or both users do not exist." << endl;
+    }
+}
+
+// Removes the friendship between two users, if there is one
+void SocialNetwork::removeFriendship(const string &user1, const string &user2) {
+    UpdateStatus status = updateFriendship({user1, user2, EdgeUpdate::Kind::Remove});
+    if (status == UpdateStatus::Applied) {
+        cout << "Friendship removed between '" << user1 << "' and '" << user2 << "'." << endl;
+    } else if (status == UpdateStatus::NoChange) {
+        cout << "'" << user1 << "' and '" << user2 << "' are not friends." << endl;
+    } else {
+        cout << "One or both users do not exist." << endl;
+    }
+}
+
+// Adds or removes one friendship without printing. Safe to call from many threads at once (but
+// not concurrently with addUser, clear, applyBatch or queries): the two friend lists are locked in
+// stripe order, and every friend-list tier inserts in time bounded by a constant block size
+// (6 inline IDs, at most 4096 sorted IDs, or one Roaring chunk).
+UpdateStatus SocialNetwork::updateFriendship(const EdgeUpdate &update) {
+    const uint32_t id1 = userIds.find(update.user1), id2 = userIds.find(update.user2);
+    if (id1 == NameIndex::kMissing || id2 == NameIndex::kMissing) return UpdateStatus::UserNotFound;
+
+    const bool add = update.kind == EdgeUpdate::Kind::Add;
+    bool changed;
+    {
+        pair<size_t, size_t> stripes = minmax(id1 % kLockStripes, id2 % kLockStripes);
+        lock_guard<SpinLock> first(userLocks[stripes.first]);
+        unique_lock<SpinLock> second(userLocks[stripes.second], defer_lock);
+        if (stripes.second != stripes.first) second.lock();
+
+        changed = add ? adjacency[id1].insert(id2) : adjacency[id1].erase(id2);
+        if (id1 != id2) add ? adjacency[id2].insert(id1) : adjacency[id2].erase(id1);
+        if (changed && versioningEnabled) pendingVersionChanges[stripes.first].push_back({id1, id2, add});
+        if (changed && friendshipFilterEnabled) add ? friendshipFilter.insert(id1, id2) : friendshipFilter.noteRemoval();
+        if (changed && sketchesEnabled) {
+            for (pair<uint32_t, uint32_t> arc : {make_pair(id1, id2), make_pair(id2, id1)}) {
+                bool resketched = add ? sketches.insert(arc.first, arc.second) : sketches.dependsOn(arc.first, arc.second);
+                if (!add && resketched) sketches.assign(arc.first, adjacency[arc.first]);
+                if (resketched) pendingSketchUsers[stripes.first].push_back(arc.first);
+            }
+        }
+
+        // Attributes are updated under the stripe locks too, so racing updates to one friendship
+        // leave its weight and time consistent with its final state
+        pair<uint32_t, uint32_t> key = minmax(id1, id2);
+        const bool timed = add && changed && update.timestamp != 0;
+        if ((add && update.weight != 1.0f) || timed) {
+            lock_guard<mutex> guard(edgeAttributesMutex);
+            if (add && update.weight != 1.0f) {
+                edgeWeights[key] = update.weight;
+                hasEdgeWeights.store(true, memory_order_relaxed);
+            } else {
+                edgeWeights.erase(key);
+            }
+            if (timed) {
+                edgeTimes[key] = update.timestamp;
+                hasEdgeTimes.store(true, memory_order_relaxed);
+            } else if (changed) {
+                edgeTimes.erase(key);
+            }
+        } else if (hasEdgeWeights.load(memory_order_relaxed) || (changed && hasEdgeTimes.load(memory_order_relaxed))) {
+            lock_guard<mutex> guard(edgeAttributesMutex);
+            edgeWeights.erase(key);
+            if (changed) edgeTimes.erase(key); // Removed, or re-created without a time
+        }
+    }
+    snapshotValid.store(false, memory_order_relaxed);
+    return changed ? UpdateStatus::Applied : UpdateStatus::NoChange;
+}
+
+// Applies a batch of friendship additions and removals without per-update output. Updates are
+// deduplicated per friendship, sorted by source user and merged into each friend list in a single
+// pass; distinct users' lists are merged in parallel.
+vector<UpdateStatus> SocialNetwork::applyBatch(const vector<EdgeUpdate> &updates) {
+    vector<UpdateStatus> status(updates.size(), UpdateStatus::NoChange);
+
+    // Resolve names to a (lower ID, higher ID) key; the index is only read here, so lookups run in
+    // parallel
+    const uint64_t missing = numeric_limits<uint64_t>::max();
+    vector<pair<uint64_t, uint32_t>> order(updates.size()); // (friendship key, update index)
+    parallelFor(updates.size(), 1024, [&](size_t begin, size_t end, unsigned) {
+        vector<string_view> names(2 * (end - begin));
+        for (size_t i = begin; i < end; ++i) {
+            names[2 * (i - begin)] = updates[i].user1;
+            names[2 * (i - begin) + 1] = updates[i].user2;
+        }
+        vector<uint32_t> ids(names.size());
+        userIds.lookup(names.data(), names.size(), ids.data());
+        for (size_t i = begin; i < end; ++i) {
+            const uint32_t id1 = ids[2 * (i - begin)], id2 = ids[2 * (i - begin) + 1];
+            if (id1 == NameIndex::kMissing || id2 == NameIndex::kMissing) {
+                order[i] = {missing, static_cast<uint32_t>(i)};
+                status[i] = UpdateStatus::UserNotFound;
+            } else {
+                pair<uint32_t, uint32_t> ends = minmax(id1, id2);
+                order[i] = {(uint64_t(ends.first) << 32) | ends.second, static_cast<uint32_t>(i)};
+            }
+        }
+    });
+
+    // Group updates by friendship, keeping batch order within each group
+    std::sort(order.begin(), order.end());
+    while (!order.empty() && order.back().first == missing) order.pop_back();
+
+    // Replay each group against the friendship's current state; only the net change is applied
+    struct ArcChange {
+        uint32_t source, target;
+        bool remove;
+        bool operator<(const ArcChange &other) const {
+            if (source != other.source) return source < other.source;
+            if (remove != other.remove) return remove < other.remove;
+            return target < other.target;
+        }
+    };
+    vector<ArcChange> changes;
+    changes.reserve(2 * order.size());
+    for (size_t groupBegin = 0, groupEnd; groupBegin < order.size(); groupBegin = groupEnd) {
+        for (groupEnd = groupBegin + 1; groupEnd < order.size() && order[groupEnd].first == order[groupBegin].first;
+             ++groupEnd) {
+        }
+        pair<uint32_t, uint32_t> key(static_cast<uint32_t>(order[groupBegin].first >> 32),
+                                     static_cast<uint32_t>(order[groupBegin].first));
+
+        const bool wasFriends = adjacency[key.first].contains(key.second);
+        bool friends = wasFriends;
+        float weight = 1.0f;
+        bool recreated = false; // The friendship was (re)created, so its creation time is `timestamp`
+        int64_t timestamp = 0;
+        for (size_t g = groupBegin; g < groupEnd; ++g) {
+            const EdgeUpdate &update = updates[order[g].second];
+            bool add = update.kind == EdgeUpdate::Kind::Add;
+            status[order[g].second] = friends != add ? UpdateStatus::Applied : UpdateStatus::NoChange;
+            if (add && !friends) {
+                recreated = true;
+                timestamp = update.timestamp;
+            }
+            friends = add;
+            if (add) weight = update.weight;
+        }
+
+        if (friends && weight != 1.0f) {
+            edgeWeights[key] = weight;
+            hasEdgeWeights.store(true, memory_order_relaxed);
+        } else if (!edgeWeights.empty()) {
+            edgeWeights.erase(key);
+        }
+        if (friends && recreated && timestamp != 0) {
+            edgeTimes[key] = timestamp;
+            hasEdgeTimes.store(true, memory_order_relaxed);
+        } else if ((!friends || recreated) && !edgeTimes.empty()) {
+            edgeTimes.erase(key);
+        }
+        if (friends != wasFriends) {
+            changes.push_back({key.first, key.second, wasFriends});
+            if (key.first != key.second) changes.push_back({key.second, key.first, wasFriends});
+        }
+    }
+    if (!order.empty()) snapshotValid = false;
+    if (changes.empty()) return status;
+
+    // Sort by source so each friend list sees its additions, then its removals, as sorted runs
+    std::sort(changes.begin(), changes.end());
+    vector<uint32_t> targets(changes.size());
+    vector<size_t> runs; // Start of each source's run of changes
+    for (size_t i = 0; i < changes.size(); ++i) {
+        targets[i] = changes[i].target;
+        if (i == 0 || changes[i].source != changes[i - 1].source) runs.push_back(i);
+    }
+    runs.push_back(changes.size());
+
+    // Merge every run in parallel; each run touches a different user's list, and the graph pool is
+    // synchronized. reserve() first switches up to the representation the merged size calls for,
+    // since mergeSorted never changes it; shrink() below switches down.
+    parallelFor(runs.size() - 1, 64, [&](size_t begin, size_t end, unsigned) {
+        for (size_t r = begin; r < end; ++r) {
+            size_t split = runs[r];
+            while (split < runs[r + 1] && !changes[split].remove) ++split;
+            NeighborSet &neighbors = adjacency[changes[runs[r]].source];
+            neighbors.reserve(neighbors.size() + (split - runs[r]) - (runs[r + 1] - split));
+            neighbors.mergeSorted(&targets[runs[r]], &targets[split], &targets[split], targets.data() + runs[r + 1]);
+        }
+    });
+
+    for (size_t r = 0; r + 1 < runs.size(); ++r) {
+        adjacency[changes[runs[r]].source].shrink();
+    }
+
+    // Keep the MinHash sketches current: additions fold into each signature, and a removal that took
+    // away one of its minima recomputes it from the merged list
+    if (sketchesEnabled) {
+        vector<uint8_t> resketched(runs.size() - 1, 0);
+        parallelFor(runs.size() - 1, 64, [&](size_t begin, size_t end, unsigned) {
+            for (size_t r = begin; r < end; ++r) {
+                const uint32_t source = changes[runs[r]].source;
+                bool rebuild = false;
+                for (size_t i = runs[r]; i < runs[r + 1]; ++i) {
+                    if (changes[i].remove) {
+                        rebuild = rebuild || sketches.dependsOn(source, targets[i]);
+                    } else if (sketches.insert(source, targets[i])) {
+                        resketched[r] = 1;
+                    }
+                }
+                if (rebuild) sketches.assign(source, adjacency[source]);
+                resketched[r] |= rebuild;
+            }
+        });
+        for (size_t r = 0; r + 1 < runs.size(); ++r) {
+            if (resketched[r]) pendingSketchUsers[0].push_back(changes[runs[r]].source);
+        }
+    }
+
+    if (friendshipFilterEnabled) {
+        for (const ArcChange &change : changes) {
+            if (change.source > change.target) continue; // Once per friendship
+            change.remove ? friendshipFilter.noteRemoval() : friendshipFilter.insert(change.source, change.target);
+        }
+    }
+
+    // Each batch becomes one new version
+    if (versioningEnabled) {
+        for (const ArcChange &change : changes) {
+            if (change.source > change.target) continue; // Log each friendship once
+            size_t stripe = min(change.source % kLockStripes, change.target % kLockStripes);
+            pendingVersionChanges[stripe].push_back({change.source, change.target, !change.remove});
+        }
+        commitVersion();
+    }
+    return status;
+}
+
+// Starts keeping immutable versions of the graph, beginning with the current state. Call it when
+// no other thread is updating the network.
+void SocialNetwork::enableVersioning() {
+    if (versioningEnabled) return;
+    const uint32_t n = static_cast<uint32_t>(userNames.size());
+    vector<pair<uint32_t, CTree>> trees(n);
+    vector<uint64_t> arcs(workerCount(), 0);
+    parallelFor(n, 256, [&](size_t begin, size_t end, unsigned worker) {
+        vector<uint32_t> ids;
+        for (size_t u = begin; u < end; ++u) {
+            ids.clear();
+            adjacency[u].forEach([&ids](uint32_t v) { ids.push_back(v); });
+            trees[u] = {static_cast<uint32_t>(u), ctreeBuild(ids.data(), ids.data() + ids.size())};
+            arcs[worker] += ids.size();
+        }
+    });
+
+    auto first = make_shared<GraphVersion>();
+    first->numVertices = n;
+    for (uint64_t count : arcs) first->numArcs += count;
+    while ((uint64_t(1) << (VertexTrieNode::kBits * first->levels)) < n) ++first->levels;
+    first->root = assignVertexTrees(nullptr, first->levels - 1, trees.data(), trees.data() + trees.size());
+    atomic_store(&latestVersion, shared_ptr<const GraphVersion>(first));
+    versioningEnabled = true;
+}
+
+// Publishes the friendship changes made since the last commit (and any new users) as a new version.
+// Safe to call while other threads run updateFriendship; writers only wait for the brief swap of
+// each stripe's change log, and readers of older versions are never disturbed.
+void SocialNetwork::commitVersion() {
+    if (!versioningEnabled) {
+        cout << "Error: Versioning is not enabled." << endl;
+        return;
+    }
+    lock_guard<mutex> guard(versionCommitMutex);
+    vector<VersionArcChange> changes;
+    for (size_t stripe = 0; stripe < kLockStripes; ++stripe) {
+        lock_guard<SpinLock> stripeGuard(userLocks[stripe]);
+        for (const VersionArcChange &change : pendingVersionChanges[stripe]) {
+            changes.push_back(change);
+            if (change.source != change.target) changes.push_back({change.target, change.source, change.add});
+        }
+        pendingVersionChanges[stripe].clear();
+    }
+
+    shared_ptr<const GraphVersion> base = atomic_load(&latestVersion);
+    const uint32_t n = static_cast<uint32_t>(userNames.size());
+    if (changes.empty() && base->numVertices == n) return;
+    // Stable, so repeated changes to one friendship stay in the order they were made
+    std::stable_sort(changes.begin(), changes.end(), [](const VersionArcChange &a, const VersionArcChange &b) {
+        return a.source != b.source ? a.source < b.source : a.target < b.target;
+    });
+    atomic_store(&latestVersion, commitGraphVersion(*base, n, changes));
+}
+
+// Returns the latest committed version (nullptr if versioning is off). Holding the pointer keeps that
+// version readable for as long as needed; it is freed once the last holder lets go.
+shared_ptr<const GraphVersion> SocialNetwork::pinVersion() const { return atomic_load(&latestVersion); }
+
+// Returns the friends of a user as of a pinned version
+set<string> SocialNetwork::getFriends(const GraphVersion &version, const string &userName) const {
+    set<string> friends;
+    const uint32_t user = userIds.find(userName);
+    if (user == NameIndex::kMissing || user >= version.numVertices) {
+        cout << "User '" << userName << "' not found in version " << version.number << "." << endl;
+        return friends;
+    }
+    ctreeForEach(version.neighbors(user), [&](uint32_t id) { friends.emplace(userNames[id]); });
+    return friends;
+}
+
+// PageRank over a pinned version; unaffected by updates made while it runs
+vector<pair<string, double>> SocialNetwork::pageRank(const GraphVersion &version, double damping, double tolerance,
+                                                     int maxIterations) const {
+    vector<double> rank = computePageRank(materializeVersion(version), damping, tolerance, maxIterations);
+
+    vector<pair<string, double>> scores;
+    scores.reserve(rank.size());
+    for (uint32_t id = 0; id < rank.size(); ++id) {
+        scores.emplace_back(userNames[id], rank[id]);
+    }
+    std::sort(scores.begin(), scores.end(), [](const pair<string, double> &a, const pair<string, double> &b) {
+        if (a.second != b.second) {
+            return a.second > b.second;
+        }
+        return a.first < b.first;
+    });
+    return scores;
+}
+
+// Returns all friends of a specific user
+set<string> SocialNetwork::getFriends(const string &userName) const {
+    set<string> friends;
+    const uint32_t user = userIds.find(userName);
+    if (user != NameIndex::kMissing) {
+        adjacency[user].forEach([&](uint32_t id) { friends.emplace(userNames[id]); });
+        return friends;
+    }
+    cout << "User '" << userName << "' not found." << endl;
+    return friends;
+}
+
+// Keeps a Bloom filter over friendships so that friendship checks (areFriends, and excluding
+// existing friends from suggestions) can usually skip the friend lists. Answers stay exact; the rate
+// only sets how often a non-friend pair still needs the list lookup. Call it when no other thread is
+// updating the network.
+void SocialNetwork::enableFriendshipFilter(double falsePositiveRate) {
+    if (!(falsePositiveRate > 0.0 && falsePositiveRate < 0.5)) {
+        cout << "Error: False-positive rate must be between 0 and 0.5." << endl;
+        return;
+    }
+    friendshipFilterRate = falsePositiveRate;
+    rebuildFriendshipFilter();
+    friendshipFilterEnabled = true;
+}
+
+// Sizes the filter for twice the current friendships, leaving room to grow, and fills it in parallel
+void SocialNetwork::rebuildFriendshipFilter() {
+    size_t arcs = 0;
+    for (const NeighborSet &friends : adjacency) arcs += friends.size();
+    friendshipFilter.reset(max<size_t>(1024, arcs), friendshipFilterRate);
+    parallelFor(adjacency.size(), 256, [&](size_t begin, size_t end, unsigned) {
+        for (size_t u = begin; u < end; ++u) {
+            adjacency[u].forEach([&](uint32_t v) {
+                if (v >= u) friendshipFilter.insert(static_cast<uint32_t>(u), v);
+            });
+        }
+    });
+}
+
+// Returns the friendship filter (nullptr when disabled), rebuilt if updates have made it stale
+const FriendshipFilter *SocialNetwork::cachedFriendshipFilter() {
+    if (!friendshipFilterEnabled) return nullptr;
+    if (friendshipFilter.stale()) rebuildFriendshipFilter();
+    return &friendshipFilter;
+}
+
+// Checks whether two users are friends. With the filter enabled, most non-friend pairs are answered
+// from one cache line of the filter.
+bool SocialNetwork::areFriends(const string &user1, const string &user2) {
+    const uint32_t id1 = userIds.find(user1), id2 = userIds.find(user2);
+    if (id1 == NameIndex::kMissing || id2 == NameIndex::kMissing) {
+        cout << "Error: One or both users ('" << user1 << "', '" << user2 << "') not found for friendship check." << endl;
+        return false;
+    }
+    return isFriend(cachedFriendshipFilter(), id1, id2);
+}
+
+// Adds an attribute column; every user starts out with a null value
+void SocialNetwork::defineAttribute(const string &attribute, AttributeType type) {
+    if (!attributes.defineColumn(attribute, type)) {
+        cout << "Error: Attribute '" << attribute << "' is already defined with another type." << endl;
+    }
+}
+
+// Resolves a user and an attribute column for the setters, reporting unknown names
+AttributeStore::Column *SocialNetwork::attributeColumn(const string &userName, const string &attribute, uint32_t &user) {
+    user = userIds.find(userName);
+    if (user == NameIndex::kMissing) {
+        cout << "Error: User '" << userName << "' not found." << endl;
+        return nullptr;
+    }
+    AttributeStore::Column *column = attributes.findColumn(attribute);
+    if (!column) {
+        cout << "Error: Attribute '" << attribute << "' is not defined." << endl;
+        return nullptr;
+    }
+    return column;
+}
+
+// Sets an integer attribute of a user
+void SocialNetwork::setAttribute(const string &userName, const string &attribute, int64_t value) {
+    uint32_t user;
+    AttributeStore::Column *column = attributeColumn(userName, attribute, user);
+    if (!column) return;
+    if (column->type != AttributeType::Int) {
+        cout << "Error: Attribute '" << attribute << "' does not hold integers." << endl;
+        return;
+    }
+    AttributeStore::setInt(*column, user, value);
+}
+
+// Sets a string attribute of a user
+void SocialNetwork::setAttribute(const string &userName, const string &attribute, const string &value) {
+    uint32_t user;
+    AttributeStore::Column *column = attributeColumn(userName, attribute, user);
+    if (!column) return;
+    if (column->type != AttributeType::String) {
+        cout << "Error: Attribute '" << attribute << "' does not hold strings." << endl;
+        return;
+    }
+    AttributeStore::setString(*column, user, value);
+}
+
+// Sets a flag attribute of a user
+void SocialNetwork::setFlag(const string &userName, const string &attribute, bool value) {
+    uint32_t user;
+    AttributeStore::Column *column = attributeColumn(userName, attribute, user);
+    if (!column) return;
+    if (column->type != AttributeType::Flag) {
+        cout << "Error: Attribute '" << attribute << "' is not a flag." << endl;
+        return;
+    }
+    AttributeStore::setFlag(*column, user, value);
+}
+
+// Resets a user's attribute to null
+void SocialNetwork::clearAttribute(const string &userName, const string &attribute) {
+    uint32_t user;
+    AttributeStore::Column *column = attributeColumn(userName, attribute, user);
+    if (column) AttributeStore::setNull(*column, user);
+}
+
+// Reports filters that name unknown attributes or compare an attribute against the wrong type
+bool SocialNetwork::checkFilter(const UserFilter &filter) const {
+    string badAttribute;
+    if (attributes.validate(filter.node(), badAttribute)) return true;
+    cout << "Error: Filter attribute '" << badAttribute << "' is not defined or has another type." << endl;
+    return false;
+}
+
+// Match bitmap of the filter over all users, built column-at-a-time. Returns an empty bitmap when
+// `probes` single-user tests are cheaper than scanning every column (see passesFilter).
+vector<uint64_t> SocialNetwork::filterBitmap(const UserFilter &filter, size_t probes) const {
+    if (filter.matchesAll() || probes * 16 < userNames.size()) return {};
+    return attributes.evaluate(filter.node(), userNames.size());
+}
+
+// Returns the friends of a user that match the filter
+set<string> SocialNetwork::getFriends(const string &userName, const UserFilter &filter) const {
+    set<string> friends;
+    const uint32_t user = userIds.find(userName);
+    if (user == NameIndex::kMissing) {
+        cout << "User '" << userName << "' not found." << endl;
+        return friends;
+    }
+    if (!checkFilter(filter)) return friends;
+    const NeighborSet &neighbors = adjacency[user];
+    vector<uint64_t> bitmap = filterBitmap(filter, neighbors.size());
+    neighbors.forEach([&](uint32_t id) {
+        if (passesFilter(filter, bitmap, id)) friends.emplace(userNames[id]);
+    });
+    return friends;
+}
+
+// Displays the entire social network structure (users and friends in name order)
+void SocialNetwork::printGraph() const {
+    cout << "\n--- Social Network Graph ---" << endl;
+    if (userNames.empty()) {
+        cout << "The network is empty." << endl;
+        return;
+    }
+    vector<uint32_t> byName(userNames.size());
+    for (uint32_t id = 0; id < byName.size(); ++id) byName[id] = id;
+    std::sort(byName.begin(), byName.end(), [this](uint32_t a, uint32_t b) { return userNames[a] < userNames[b]; });
+
+    vector<string_view> friendNames;
+    for (uint32_t id : byName) {
+        friendNames.clear();
+        adjacency[id].forEach([&](uint32_t friendId) { friendNames.push_back(userNames[friendId]); });
+        std::sort(friendNames.begin(), friendNames.end());
+
+        cout << "'" << userNames[id] << "' is friends with: {";
+        string separator = "";
+        for (string_view friendName : friendNames) {
+            cout << separator << "'" << friendName << "'";
+            separator = ", ";
+        }
+        cout << "}" << endl;
+    }
+    cout << "----------------------------\n" << endl;
+}
+
+// Finds common friends between two users, using the intersection kernel that matches both
+// friend sets' representations (array-array, array-bitmap or bitmap-bitmap). With a time window,
+// only friends whose friendships with both users were created inside it count; those rows are
+// read from the snapshot's time index.
+set<string> SocialNetwork::getMutualFriends(const string &user1, const string &user2, const TimeWindow &window) {
+    set<string> mutualFriends;
+    const uint32_t id1 = userIds.find(user1), id2 = userIds.find(user2);
+
+    if (id1 == NameIndex::kMissing || id2 == NameIndex::kMissing) {
+        cout << "Error: One or both users ('" << user1 << "', '" << user2 << "') not found for mutual friends calculation." << endl;
+        return mutualFriends;
+    }
+
+    // Find intersection of two friend sets
+    pmr::vector<uint32_t> common(queryScratch());
+    if (window.unbounded()) {
+        intersectNeighborSets(adjacency[id1], adjacency[id2], common);
+        for (uint32_t id : common) {
+            mutualFriends.emplace(userNames[id]);
+        }
+        return mutualFriends;
+    }
+
+    // Window rows are in time order; sort copies by ID before merging
+    const CSRGraph &g = getSnapshot();
+    pair<const uint32_t *, const uint32_t *> row1 = g.neighborsInWindow(snapshotVertex[id1], window);
+    pair<const uint32_t *, const uint32_t *> row2 = g.neighborsInWindow(snapshotVertex[id2], window);
+    pmr::vector<uint32_t> friends1(row1.first, row1.second, queryScratch());
+    pmr::vector<uint32_t> friends2(row2.first, row2.second, queryScratch());
+    std::sort(friends1.begin(), friends1.end());
+    std::sort(friends2.begin(), friends2.end());
+    set_intersection(friends1.begin(), friends1.end(), friends2.begin(), friends2.end(), back_inserter(common));
+    for (uint32_t vertex : common) {
+        mutualFriends.emplace(vertexName(vertex));
+    }
+    return mutualFriends;
+}
+
+// Suggests potential friends based on mutual connections (friend-of-friend algorithm).
+// Candidates whose k-core number is below minCoreNumber are pruned (0 keeps everyone).
+// Runs over the CSR snapshot, counting mutual friends in a reusable per-vertex array. With a time
+// window, both hops follow only friendships created inside it (existing friends are still excluded).
+// Only candidates matching the attribute filter are suggested.
+vector<pair<string, int>> SocialNetwork::suggestFriends(const string &userName, uint32_t minCoreNumber,
+                                                        const TimeWindow &window, const UserFilter &filter) {
+    vector<pair<string, int>> sortedSuggestions;
+
+    const CSRGraph &g = getSnapshot();
+    uint32_t user;
+    if (!findVertex(userName, user)) {
+        cout << "Error: User '" << userName << "' not found for friend suggestions." << endl;
+        return sortedSuggestions;
+    }
+    if (!checkFilter(filter)) return sortedSuggestions;
+
+    const vector<uint32_t> *cores = minCoreNumber > 0 ? &cachedCoreNumbers() : nullptr;
+    const FriendshipFilter *friendFilter = cachedFriendshipFilter();
+    mutualCountScratch.resize(g.numVertices(), 0);
+    pmr::vector<uint32_t> touched(queryScratch());
+
+    // Iterate through each direct friend, looking at friends-of-friends
+    pair<const uint32_t *, const uint32_t *> friends = g.neighborsInWindow(user, window);
+    for (const uint32_t *friendId = friends.first; friendId != friends.second; ++friendId) {
+        pair<const uint32_t *, const uint32_t *> candidates = g.neighborsInWindow(*friendId, window);
+        for (const uint32_t *candidate = candidates.first; candidate != candidates.second; ++candidate) {
+            if (mutualCountScratch[*candidate]++ == 0) touched.push_back(*candidate);
+        }
+    }
+
+    const vector<uint64_t> matches = filterBitmap(filter, touched.size());
+    for (uint32_t candidate : touched) {
+        int count = mutualCountScratch[candidate];
+        mutualCountScratch[candidate] = 0;
+        // Skip the user and existing friends (Bloom filter first when enabled, then the friend list)
+        if (candidate == user || isFriend(friendFilter, snapshotOrder[user], snapshotOrder[candidate])) continue;
+        if (cores && (*cores)[candidate] < minCoreNumber) continue;
+        if (!passesFilter(filter, matches, snapshotOrder[candidate])) continue;
+        sortedSuggestions.emplace_back(vertexName(candidate), count);
+    }
+
+    // Sort by number of mutual connections (descending) and name (ascending)
+    std::sort(sortedSuggestions.begin(), sortedSuggestions.end(),
+              [](const pair<string, int> &a, const pair<string, int> &b) {
+                  if (a.second != b.second) {
+                      return a.second > b.second;
+                  }
+                  return a.first < b.first;
+              });
+
+    return sortedSuggestions;
+}
+
+// Finds shortest path between users using Breadth-First Search over the CSR snapshot, optionally
+// following only friendships created inside a time window and passing only through users that
+// match the attribute filter (the two endpoints always qualify)
+pair<int, list<string>> SocialNetwork::shortestPathBFS(const string &startUser, const string &endUser,
+                                                       const TimeWindow &window, const UserFilter &filter) {
+    list<string> path;
+    int distance = -1; // -1 indicates no path found
+
+    // Validate input users exist
+    const CSRGraph &g = getSnapshot();
+    uint32_t start, end;
+    if (!findVertex(startUser, start)) {
+        cout << "Error: Start user '" << startUser << "' not found for BFS." << endl;
+        return {distance, path};
+    }
+    if (!findVertex(endUser, end)) {
+        cout << "Error: End user '" << endUser << "' not found for BFS." << endl;
+        return {distance, path};
+    }
+    if (!checkFilter(filter)) return {distance, path};
+
+    // Special case: path to self
+    if (start == end) {
+        path.push_back(startUser);
+        return {0, path};
+    }
+
+    const uint32_t unvisited = numeric_limits<uint32_t>::max(), excluded = unvisited - 1;
+    pmr::vector<uint32_t> parent(queryScratch()); // For path reconstruction
+    bool found = false;
+    if (window.unbounded() && filter.matchesAll() && workerCount() > 1 && g.numArcs() >= kParallelBFSMinArcs) {
+        // Large unrestricted searches run level-synchronously on all cores
+        BFSTree tree = computeParallelBFS(g, start, end);
+        found = tree.depth[end] != BFSTree::kUnreached;
+        parent.assign(tree.parent.begin(), tree.parent.end());
+    } else {
+        // BFS algorithm implementation; the visit order vector doubles as the queue
+        parent.assign(g.numVertices(), unvisited);
+        pmr::vector<uint32_t> frontier(1, start, queryScratch());
+        parent[start] = start;
+        const vector<uint64_t> matches = filterBitmap(filter, g.numVertices());
+
+        for (size_t head = 0; head < frontier.size() && !found; ++head) {
+            uint32_t current = frontier[head];
+
+            // Explore all neighbors
+            pair<const uint32_t *, const uint32_t *> neighbors = g.neighborsInWindow(current, window);
+            for (const uint32_t *neighbor = neighbors.first; neighbor != neighbors.second; ++neighbor) {
+                if (parent[*neighbor] == unvisited) {
+                    if (*neighbor != end && !passesFilter(filter, matches, snapshotOrder[*neighbor])) {
+                        parent[*neighbor] = excluded; // Tested once, never entered
+                        continue;
+                    }
+                    parent[*neighbor] = current;
+                    frontier.push_back(*neighbor);
+
+                    if (*neighbor == end) {
+                        found = true;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    // Reconstruct path if one was found
+    if (found) {
+        for (uint32_t current = end; current != start; current = parent[current]) {
+            path.emplace_front(vertexName(current));
+        }
+        path.push_front(startUser);
+        distance = static_cast<int>(path.size()) - 1;
+    } else {
+        cout << "BFS: No path found between '" << startUser << "' and '" << endUser << "'." << endl;
+    }
+
+    return {distance, path};
+}
+
+// Finds up to k loopless paths between two users, shortest first (in hops),
+// with Yen's algorithm. Each later path branches off an earlier one at a "spur" user: the part
+// before the spur is kept, its users are blocked, the next hops taken by already-found paths with
+// the same beginning are cut, and a bidirectional BFS finds the rest. The BFS workspace is reused
+// across spurs and queries.
+vector<list<string>> SocialNetwork::kShortestPaths(const string &startUser, const string &endUser, size_t k) {
+    vector<list<string>> paths;
+    const CSRGraph &g = getSnapshot();
+    uint32_t start, end;
+    if (!findVertex(startUser, start)) {
+        cout << "Error: Start user '" << startUser << "' not found for k shortest paths." << endl;
+        return paths;
+    }
+    if (!findVertex(endUser, end)) {
+        cout << "Error: End user '" << endUser << "' not found for k shortest paths." << endl;
+        return paths;
+    }
+    if (k == 0) return paths;
+
+    const uint32_t n = g.numVertices();
+    vector<vector<uint32_t>> accepted(1), candidates;
+    pathWorkspace.reset(n);
+    if (!pathWorkspace.search(g, start, end, accepted[0])) {
+        cout << "No path found between '" << startUser << "' and '" << endUser << "'." << endl;
+        return paths;
+    }
+    auto shorter = [this](const vector<uint32_t> &a, const vector<uint32_t> &b) {
+        if (a.size() != b.size()) {
+            return a.size() < b.size();
+        }
+        return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(),
+                                            [this](uint32_t x, uint32_t y) { return vertexName(x) < vertexName(y); });
+    };
+
+    vector<uint32_t> spurPath;
+    while (accepted.size() < k) {
+        const vector<uint32_t> last = accepted.back();
+        for (size_t i = 0; i + 1 < last.size(); ++i) {
+            pathWorkspace.reset(n);
+            for (size_t j = 0; j < i; ++j) pathWorkspace.block(last[j]);
+            for (const vector<uint32_t> &path : accepted) {
+                if (path.size() > i + 1 && std::equal(last.begin(), last.begin() + i + 1, path.begin())) {
+                    pathWorkspace.cutFromSource(path[i + 1]);
+                }
+            }
+            if (!pathWorkspace.search(g, last[i], end, spurPath)) continue;
+            vector<uint32_t> candidate(last.begin(), last.begin() + i);
+            candidate.insert(candidate.end(), spurPath.begin(), spurPath.end());
+            if (std::find(candidates.begin(), candidates.end(), candidate) == candidates.end()) {
+                candidates.push_back(std::move(candidate));
+            }
+        }
+        if (candidates.empty()) break; // Every loopless path has been found
+        auto best = std::min_element(candidates.begin(), candidates.end(), shorter);
+        accepted.push_back(std::move(*best));
+        candidates.erase(best);
+    }
+
+    for (const vector<uint32_t> &path : accepted) {
+        list<string> &names = paths.emplace_back();
+        for (uint32_t v : path) names.emplace_back(vertexName(v));
+    }
+    return paths;
+}
+
+// Counts the distinct shortest paths between two users with a bidirectional BFS that stops where the
+// two searches meet, and optionally draws up to `samples` distinct ones uniformly at random
+ShortestPathCount SocialNetwork::countShortestPaths(const string &startUser, const string &endUser, size_t samples) {
+    ShortestPathCount result;
+    const CSRGraph &g = getSnapshot();
+    uint32_t start, end;
+    if (!findVertex(startUser, start)) {
+        cout << "Error: Start user '" << startUser << "' not found for path counting." << endl;
+        return result;
+    }
+    if (!findVertex(endUser, end)) {
+        cout << "Error: End user '" << endUser << "' not found for path counting." << endl;
+        return result;
+    }
+
+    pathWorkspace.reset(g.numVertices());
+    result.distance = pathWorkspace.countPaths(g, start, end, result.count);
+    if (result.distance < 0) {
+        result.count = 0;
+        return result;
+    }
+
+    // Draws repeat paths, so give up after a few times as many draws as requested
+    FastRng rng((uint64_t(snapshotOrder[start]) << 32) | snapshotOrder[end]);
+    set<vector<uint32_t>> drawn;
+    vector<uint32_t> path;
+    const size_t wanted = result.count < samples ? static_cast<size_t>(result.count) : samples;
+    for (size_t draw = 0; drawn.size() < wanted && draw < 8 * samples; ++draw) {
+        pathWorkspace.samplePath(g, start, end, rng, path);
+        if (!drawn.insert(path).second) continue;
+        list<string> &names = result.samples.emplace_back();
+        for (uint32_t v : path) names.emplace_back(vertexName(v));
+    }
+    return result;
+}
+
+// Finds shortest path using Dijkstra's algorithm (optimal for weighted graphs)
+pair<int, list<string>> SocialNetwork::shortestPathDijkstra(const string &startUser, const string &endUser) {
+    list<string> path;
+    int finalDistance = -1; // Default: no path found
+
+    // Validate input users exist
+    const uint32_t start = userIds.find(startUser), end = userIds.find(endUser);
+    if (start == NameIndex::kMissing) {
+        cout << "Error: Start user '" << startUser << "' not found for Dijkstra." << endl;
+        return {finalDistance, path};
+    }
+    if (end == NameIndex::kMissing) {
+        cout << "Error: End user '" << endUser << "' not found for Dijkstra." << endl;
+        return {finalDistance, path};
+    }
+
+    // Special case: path to self
+    if (start == end) {
+        path.push_back(startUser);
+        return {0, path};
+    }
+
+    // Define INF constant for "infinity" distance
+    const int INF = numeric_limits<int>::max();
+    const uint32_t NONE = numeric_limits<uint32_t>::max();
+
+    // Dijkstra algorithm implementation
+    pmr::vector<int> dist(userNames.size(), INF, queryScratch());         // Track shortest distance to each node
+    pmr::vector<uint32_t> parent(userNames.size(), NONE, queryScratch()); // For path reconstruction
+    using QueueEntry = pair<int, uint32_t>;
+    priority_queue<QueueEntry, pmr::vector<QueueEntry>, greater<QueueEntry>> pq{
+        greater<QueueEntry>(), pmr::vector<QueueEntry>(queryScratch())}; // Min-priority queue
+
+    // Start with startUser
+    dist[start] = 0;
+    pq.push({0, start});
+
+    bool found = false;
+    while (!pq.empty()) {
+        int d = pq.top().first;
+        uint32_t u = pq.top().second;
+        pq.pop();
+
+        // Skip outdated entries in priority queue
+        if (d > dist[u]) {
+            continue;
+        }
+
+        // Check if we've reached the destination
+        if (u == end) {
+            found = true;
+            finalDistance = dist[u];
+            break;
+        }
+
+        // Explore all neighbors
+        adjacency[u].forEach([&](uint32_t v) {
+            int weight = 1; // Assuming unweighted graph (each edge has weight 1)
+
+            // Relaxation step: if we found a shorter path to v through u
+            if (dist[u] != INF && dist[u] + weight < dist[v]) {
+                dist[v] = dist[u] + weight;
+                parent[v] = u;
+                pq.push({dist[v], v});
+            }
+        });
+    }
+
+    // Reconstruct path if one was found
+    if (found) {
+        for (uint32_t current = end; current != NONE; current = parent[current]) {
+            path.emplace_front(userNames[current]);
+        }
+    } else {
+        cout << "Dijkstra: No path found between '" << startUser << "' and '" << endUser << "'." << endl;
+    }
+
+    return {finalDistance, path};
+}
+
+// Resolves a user name to its vertex in the current CSR snapshot (call getSnapshot first)
+bool SocialNetwork::findVertex(const string &userName, uint32_t &vertex) const {
+    const uint32_t user = userIds.find(userName);
+    if (user == NameIndex::kMissing) return false;
+    vertex = snapshotVertex[user];
+    return true;
+}
+
+// Selects the vertex ordering applied the next time the CSR snapshot is built
+void SocialNetwork::setReorderStrategy(ReorderStrategy strategy) {
+    if (strategy != reorderStrategy) {
+        reorderStrategy = strategy;
+        snapshotValid = false;
+    }
+}
+
+// Returns the CSR snapshot of the current graph, rebuilding it if the graph changed since the last build.
+// Vertices are renumbered by the selected reorder strategy; user IDs and names are unaffected.
+const CSRGraph &SocialNetwork::getSnapshot() {
+    if (snapshotValid) return snapshot;
+
+    const uint32_t n = static_cast<uint32_t>(userNames.size());
+    snapshot.offsets.assign(n + 1, 0);
+    for (uint32_t u = 0; u < n; ++u) {
+        snapshot.offsets[u + 1] = snapshot.offsets[u] + adjacency[u].size();
+    }
+    snapshot.neighbors.resize(snapshot.offsets[n]);
+    snapshot.weights.clear();
+    snapshot.times.clear();
+    snapshot.timeOrdered.clear();
+    snapshot.timeOrderedTimes.clear();
+    if (!edgeWeights.empty()) snapshot.weights.resize(snapshot.offsets[n]);
+    if (!edgeTimes.empty()) snapshot.times.resize(snapshot.offsets[n]);
+    for (uint32_t u = 0; u < n; ++u) {
+        // Neighbor sets iterate in ascending ID order, so rows come out sorted
+        uint64_t out = snapshot.offsets[u];
+        adjacency[u].forEach([&](uint32_t v) {
+            if (!snapshot.weights.empty()) {
+                auto w = edgeWeights.find(minmax(u, v));
+                snapshot.weights[out] = w != edgeWeights.end() ? w->second : 1.0f;
+            }
+            if (!snapshot.times.empty()) {
+                auto t = edgeTimes.find(minmax(u, v));
+                snapshot.times[out] = t != edgeTimes.end() ? t->second : 0;
+            }
+            snapshot.neighbors[out++] = v;
+        });
+    }
+
+    snapshotOrder = computeReordering(snapshot, reorderStrategy);
+    if (reorderStrategy != ReorderStrategy::None) {
+        snapshot = permuteGraph(snapshot, snapshotOrder); // Also rebuilds the time index
+    } else if (!snapshot.times.empty()) {
+        buildTimeIndex(snapshot);
+    }
+    snapshotVertex.resize(n);
+    for (uint32_t v = 0; v < n; ++v) snapshotVertex[snapshotOrder[v]] = v;
+
+    aliasTablesValid = false;
+    coreNumbersValid = false;
+    searchDegreesValid = false;
+    similarityTablesValid = false;
+    snapshotValid = true;
+    return snapshot;
+}
+
+// Returns a compressed copy of the CSR snapshot (same vertex numbering), for memory-bound deployments
+CompressedCSRGraph SocialNetwork::getCompressedSnapshot() {
+    return compressGraph(getSnapshot());
+}
+
+// Returns a BV/WebGraph-compressed copy of the CSR snapshot (same vertex numbering). Reference
+// compression works best after a locality-improving reorder strategy has been selected.
+WebGraphCompressed SocialNetwork::getWebGraphSnapshot() {
+    return webGraphCompress(getSnapshot());
+}
+
+// Computes global PageRank influence scores, sorted by score (descending)
+vector<pair<string, double>> SocialNetwork::pageRank(double damping, double tolerance, int maxIterations) {
+    const CSRGraph &g = getSnapshot();
+    vector<double> rank = computePageRank(g, damping, tolerance, maxIterations);
+
+    vector<pair<string, double>> scores;
+    scores.reserve(rank.size());
+    for (uint32_t v = 0; v < rank.size(); ++v) {
+        scores.emplace_back(vertexName(v), rank[v]);
+    }
+    std::sort(scores.begin(), scores.end(), [](const pair<string, double> &a, const pair<string, double> &b) {
+        if (a.second != b.second) {
+            return a.second > b.second;
+        }
+        return a.first < b.first;
+    });
+    return scores;
+}
+
+// Suggests the top-k non-friends ranked by personalized PageRank from the given user
+vector<pair<string, double>> SocialNetwork::suggestFriendsPPR(const string &userName, size_t k, double epsilon) {
+    vector<pair<string, double>> suggestions;
+    const CSRGraph &g = getSnapshot();
+    uint32_t source;
+    if (!findVertex(userName, source)) {
+        cout << "Error: User '" << userName << "' not found for PPR suggestions." << endl;
+        return suggestions;
+    }
+
+    unordered_map<uint32_t, double> ppr = computePersonalizedPageRank(g, source, 0.85, epsilon);
+
+    vector<pair<uint32_t, double>> candidates;
+    for (const auto &entry : ppr) {
+        // Skip the user and existing friends (neighbor lists are sorted)
+        if (entry.first == source || std::binary_search(g.begin(source), g.end(source), entry.first)) continue;
+        candidates.push_back(entry);
+    }
+    auto byScore = [this](const pair<uint32_t, double> &a, const pair<uint32_t, double> &b) {
+        if (a.second != b.second) {
+            return a.second > b.second;
+        }
+        return vertexName(a.first) < vertexName(b.first);
+    };
+    size_t top = min(k, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + top, candidates.end(), byScore);
+
+    for (size_t i = 0; i < top; ++i) {
+        suggestions.emplace_back(vertexName(candidates[i].first), candidates[i].second);
+    }
+    return suggestions;
+}
+
+// Degree, 1/degree and 1/ln(degree) per snapshot vertex, rebuilt after the graph changes
+const SimilarityTables &SocialNetwork::cachedSimilarityTables() {
+    const CSRGraph &g = getSnapshot();
+    if (!similarityTablesValid) {
+        const uint32_t n = g.numVertices();
+        similarityTables.degree.resize(n);
+        similarityTables.inverseDegree.resize(n);
+        similarityTables.inverseLogDegree.resize(n);
+        parallelFor(n, 4096, [&](size_t begin, size_t end, unsigned) {
+            for (size_t v = begin; v < end; ++v) {
+                const uint32_t degree = g.degree(static_cast<uint32_t>(v));
+                similarityTables.degree[v] = degree;
+                similarityTables.inverseDegree[v] = degree > 0 ? 1.0 / degree : 0.0;
+                similarityTables.inverseLogDegree[v] = degree > 1 ? 1.0 / log(double(degree)) : 0.0;
+            }
+        });
+        similarityTablesValid = true;
+    }
+    return similarityTables;
+}
+
+// Suggests the top-k non-friends by a link-prediction score (a scorer such as JaccardScore or
+// AdamicAdarScore), accumulated in one sweep over friends-of-friends
+template <typename Scorer>
+vector<pair<string, double>> SocialNetwork::suggestFriendsBy(const string &userName, size_t k) {
+    vector<pair<string, double>> suggestions;
+    const CSRGraph &g = getSnapshot();
+    uint32_t user;
+    if (!findVertex(userName, user)) {
+        cout << "Error: User '" << userName << "' not found for similarity suggestions." << endl;
+        return suggestions;
+    }
+
+    const SimilarityTables &tables = cachedSimilarityTables();
+    similarityScratch.resize(g.numVertices(), 0.0);
+    mutualCountScratch.resize(g.numVertices(), 0);
+    pmr::vector<uint32_t> touched(queryScratch());
+    for (const uint32_t *friendId = g.begin(user); friendId != g.end(user); ++friendId) {
+        const double weight = Scorer::pathWeight(tables, *friendId);
+        for (const uint32_t *candidate = g.begin(*friendId); candidate != g.end(*friendId); ++candidate) {
+            if (mutualCountScratch[*candidate]++ == 0) touched.push_back(*candidate);
+            similarityScratch[*candidate] += weight;
+        }
+    }
+
+    vector<pair<uint32_t, double>> candidates;
+    for (uint32_t candidate : touched) {
+        const double sum = similarityScratch[candidate];
+        similarityScratch[candidate] = 0.0;
+        mutualCountScratch[candidate] = 0;
+        // Skip the user and existing friends (neighbor lists are sorted)
+        if (candidate == user || std::binary_search(g.begin(user), g.end(user), candidate)) continue;
+        candidates.emplace_back(candidate, Scorer::score(sum, tables.degree[user], tables.degree[candidate]));
+    }
+    auto byScore = [this](const pair<uint32_t, double> &a, const pair<uint32_t, double> &b) {
+        if (a.second != b.second) {
+            return a.second > b.second;
+        }
+        return vertexName(a.first) < vertexName(b.first);
+    };
+    size_t top = min(k, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + top, candidates.end(), byScore);
+
+    for (size_t i = 0; i < top; ++i) {
+        suggestions.emplace_back(vertexName(candidates[i].first), candidates[i].second);
+    }
+    return suggestions;
+}
+
+// Suggests the top-k non-friends by random walk with restart, sampling weighted edges through alias tables.
+// The walk budget bounds the cost regardless of the user's degree, trading accuracy for latency.
+vector<pair<string, double>> SocialNetwork::suggestFriendsRandomWalk(const string &userName, size_t k, size_t walkBudget,
+                                                                     double restartProbability) {
+    vector<pair<string, double>> suggestions;
+    const CSRGraph &g = getSnapshot();
+    uint32_t source;
+    if (!findVertex(userName, source)) {
+        cout << "Error: User '" << userName << "' not found for random walk suggestions." << endl;
+        return suggestions;
+    }
+
+    if (!aliasTablesValid) {
+        aliasTables = buildAliasTables(g);
+        aliasTablesValid = true;
+    }
+    unordered_map<uint32_t, uint32_t> visits = sampleRandomWalkVisits(g, aliasTables, source, walkBudget, restartProbability);
+
+    vector<pair<uint32_t, uint32_t>> candidates;
+    for (const auto &entry : visits) {
+        if (std::binary_search(g.begin(source), g.end(source), entry.first)) continue;
+        candidates.push_back(entry);
+    }
+    auto byVisits = [this](const pair<uint32_t, uint32_t> &a, const pair<uint32_t, uint32_t> &b) {
+        if (a.second != b.second) {
+            return a.second > b.second;
+        }
+        return vertexName(a.first) < vertexName(b.first);
+    };
+    size_t top = min(k, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + top, candidates.end(), byVisits);
+
+    for (size_t i = 0; i < top; ++i) {
+        suggestions.emplace_back(vertexName(candidates[i].first), static_cast<double>(candidates[i].second) / walkBudget);
+    }
+    return suggestions;
+}
+
+// Computes betweenness centrality to surface "bridge" users, sorted by score (descending).
+// With pivots == 0 (or pivots >= number of users) every user is a BFS source and the scores are exact;
+// otherwise that many random pivots are sampled and the scores are extrapolated. The first element of
+// the result is the additive error bound that holds with the given confidence (0 for exact runs).
+pair<double, vector<pair<string, double>>> SocialNetwork::betweennessCentrality(size_t pivots, double confidence) {
+    const CSRGraph &g = getSnapshot();
+    const uint32_t n = g.numVertices();
+
+    vector<uint32_t> sources;
+    double errorBound = 0.0;
+    double scale = 1.0;
+    if (pivots == 0 || pivots >= n) {
+        sources = samplePivots(n, n, 0);
+    } else {
+        sources = samplePivots(n, pivots, n * 0x9E3779B9ULL + pivots);
+        errorBound = betweennessErrorBound(n, pivots, confidence);
+        scale = static_cast<double>(n) / pivots;
+    }
+    vector<double> centrality = computeBetweenness(g, sources);
+
+    vector<pair<string, double>> scores;
+    scores.reserve(n);
+    for (uint32_t v = 0; v < n; ++v) {
+        scores.emplace_back(vertexName(v), centrality[v] * scale);
+    }
+    std::sort(scores.begin(), scores.end(), [](const pair<string, double> &a, const pair<string, double> &b) {
+        if (a.second != b.second) {
+            return a.second > b.second;
+        }
+        return a.first < b.first;
+    });
+    return {errorBound, scores};
+}
+
+// Estimates the neighborhood function N(t), the number of user pairs within t hops, with HyperANF
+vector<double> SocialNetwork::neighborhoodFunction(int maxHops, int log2Registers) {
+    return computeHyperAnf(getSnapshot(), maxHops, log2Registers).neighborhoodFunction;
+}
+
+// Estimates, for every user, how many users are within the given number of hops (including themselves)
+vector<pair<string, double>> SocialNetwork::reachEstimates(int hops, int log2Registers) {
+    HyperAnfResult anf = computeHyperAnf(getSnapshot(), hops, log2Registers);
+
+    vector<pair<string, double>> reach;
+    reach.reserve(anf.reach.size());
+    for (uint32_t v = 0; v < anf.reach.size(); ++v) {
+        reach.emplace_back(vertexName(v), anf.reach[v]);
+    }
+    std::sort(reach.begin(), reach.end(), [](const pair<string, double> &a, const pair<string, double> &b) {
+        if (a.second != b.second) {
+            return a.second > b.second;
+        }
+        return a.first < b.first;
+    });
+    return reach;
+}
+
+// Counts users by exact hop distance from a user (index 0 is the user), over the whole reachable
+// network. Runs the level-synchronous parallel BFS.
+vector<uint32_t> SocialNetwork::hopCounts(const string &userName) {
+    const CSRGraph &g = getSnapshot();
+    uint32_t source;
+    if (!findVertex(userName, source)) {
+        cout << "Error: User '" << userName << "' not found for hop counts." << endl;
+        return {};
+    }
+    return computeParallelBFS(g, source).levelSizes;
+}
+
+// Estimates the effective diameter: hops needed to cover the given quantile of reachable user pairs
+double SocialNetwork::effectiveDiameter(double quantile, int log2Registers) {
+    return ::effectiveDiameter(neighborhoodFunction(numeric_limits<int>::max(), log2Registers), quantile);
+}
+
+// Returns the core number of every snapshot vertex, computing it once per snapshot
+const vector<uint32_t> &SocialNetwork::cachedCoreNumbers() {
+    const CSRGraph &g = getSnapshot();
+    if (!coreNumbersValid) {
+        coreNumberCache = workerCount() > 1 ? computeCoreNumbersParallel(g) : computeCoreNumbers(g);
+        coreNumbersValid = true;
+    }
+    return coreNumberCache;
+}
+
+// Returns each user's k-core number, sorted by core number (descending)
+vector<pair<string, uint32_t>> SocialNetwork::coreNumbers() {
+    const vector<uint32_t> &cores = cachedCoreNumbers();
+
+    vector<pair<string, uint32_t>> result;
+    result.reserve(cores.size());
+    for (uint32_t v = 0; v < cores.size(); ++v) {
+        result.emplace_back(vertexName(v), cores[v]);
+    }
+    std::sort(result.begin(), result.end(), [](const pair<string, uint32_t> &a, const pair<string, uint32_t> &b) {
+        if (a.second != b.second) {
+            return a.second > b.second;
+        }
+        return a.first < b.first;
+    });
+    return result;
+}
+
+// Extracts the k-core (users with core number >= k) as a CSR view; vertexIds map back to user IDs
+CSRSubgraph SocialNetwork::kCoreSubgraph(uint32_t k) {
+    const vector<uint32_t> &cores = cachedCoreNumbers();
+    vector<uint32_t> members;
+    for (uint32_t v = 0; v < cores.size(); ++v) {
+        if (cores[v] >= k) members.push_back(v);
+    }
+    CSRSubgraph sub = inducedSubgraph(getSnapshot(), members);
+    for (uint32_t &id : sub.vertexIds) id = snapshotOrder[id];
+    return sub;
+}
+
+// Extracts the users within `radius` hops of a user, and the friendships among them, in one BFS.
+// At most maxNodes users are kept. The vertices of a layer are expanded from lowest to highest
+// degree, each taking an equal share of the remaining budget, so only hubs are cut short: they
+// contribute friends in an evenly strided order (coprime stride, start offset from a hash of the
+// two users), so the same query returns the same sample.
+EgoNetwork SocialNetwork::egoNetwork(const string &userName, uint32_t radius, size_t maxNodes) {
+    EgoNetwork ego;
+    const CSRGraph &g = getSnapshot();
+    uint32_t center;
+    if (!findVertex(userName, center)) {
+        cout << "Error: User '" << userName << "' not found for ego network." << endl;
+        return ego;
+    }
+    if (maxNodes == 0) return ego;
+
+    pmr::vector<uint32_t> members(1, center, queryScratch()); // Snapshot vertices in local ID order
+    pmr::unordered_map<uint32_t, uint32_t> localId(queryScratch());
+    localId.emplace(center, 0);
+    ego.hops.push_back(0);
+    auto include = [&](uint32_t v, uint32_t hop) {
+        if (localId.emplace(v, static_cast<uint32_t>(members.size())).second) {
+            members.push_back(v);
+            ego.hops.push_back(hop);
+        }
+    };
+
+    for (uint32_t hop = 1, layerBegin = 0; hop <= radius && members.size() < maxNodes; ++hop) {
+        const uint32_t layerEnd = static_cast<uint32_t>(members.size());
+        pmr::vector<uint32_t> layer(members.begin() + layerBegin, members.begin() + layerEnd, queryScratch());
+        std::sort(layer.begin(), layer.end(), [&g](uint32_t a, uint32_t b) {
+            return g.degree(a) != g.degree(b) ? g.degree(a) < g.degree(b) : a < b;
+        });
+        for (size_t i = 0; i < layer.size() && members.size() < maxNodes; ++i) {
+            const uint32_t v = layer[i], degree = g.degree(v);
+            const size_t remaining = layer.size() - i;
+            const size_t share = (maxNodes - members.size() + remaining - 1) / remaining;
+            if (degree <= share) {
+                for (const uint32_t *u = g.begin(v); u != g.end(v); ++u) include(*u, hop);
+                continue;
+            }
+            uint64_t stride = degree / share;
+            while (gcd(stride, uint64_t(degree)) != 1) ++stride;
+            const uint64_t h = ((uint64_t(snapshotOrder[center]) << 32) | snapshotOrder[v]) * 0x9E3779B97F4A7C15ULL;
+            const size_t limit = members.size() + share;
+            for (uint64_t k = 0, position = (h >> 32) % degree; k < degree && members.size() < min(limit, maxNodes);
+                 ++k, position = (position + stride) % degree) {
+                include(g.begin(v)[position], hop);
+            }
+        }
+        layerBegin = layerEnd;
+    }
+
+    // Induced friendships: scan short rows, and probe hubs' rows for each member instead
+    const uint32_t n = static_cast<uint32_t>(members.size());
+    ego.graph.offsets.assign(n + 1, 0);
+    for (uint32_t i = 0; i < n; ++i) {
+        const uint32_t v = members[i];
+        const size_t rowStart = ego.graph.neighbors.size();
+        if (g.degree(v) <= 8 * size_t(n)) {
+            for (const uint32_t *u = g.begin(v); u != g.end(v); ++u) {
+                auto it = localId.find(*u);
+                if (it != localId.end()) ego.graph.neighbors.push_back(it->second);
+            }
+            std::sort(ego.graph.neighbors.begin() + rowStart, ego.graph.neighbors.end());
+        } else {
+            for (uint32_t j = 0; j < n; ++j) {
+                if (std::binary_search(g.begin(v), g.end(v), members[j])) ego.graph.neighbors.push_back(j);
+            }
+        }
+        ego.graph.offsets[i + 1] = ego.graph.neighbors.size();
+    }
+    ego.names.reserve(n);
+    for (uint32_t v : members) ego.names.emplace_back(vertexName(v));
+    return ego;
+}
+
+// Assigns every user a community ID; returns the partition's modularity and the (user, community)
+// pairs sorted by community, then name
+pair<double, vector<pair<string, uint32_t>>> SocialNetwork::detectCommunities(CommunityMethod method) {
+    const CSRGraph &g = getSnapshot();
+    CommunityAssignment assignment =
+        method == CommunityMethod::Louvain ? computeLouvain(g, 16) : computeLabelPropagation(g, 50);
+
+    vector<pair<string, uint32_t>> communities;
+    communities.reserve(assignment.community.size());
+    for (uint32_t v = 0; v < assignment.community.size(); ++v) {
+        communities.emplace_back(vertexName(v), assignment.community[v]);
     }
+    std::sort(communities.begin(), communities.end(), [](const pair<string, uint32_t> &a, const pair<string, uint32_t> &b) {
+        if (a.second != b.second) {
+            return a.second < b.second;
+        }
+        return a.first < b.first;
+    });
+    return {assignment.modularity, communities};
 }
 
-// Creates a bidirectional friendship between two users
-void SocialNetwork::addFriendship(const string &user1, const string &user2) {
-    if (adj.find(user1) != adj.end() && adj.find(user2) != adj.end()) {
-        adj[user1].insert(user2);
-        adj[user2].insert(user1);
-        cout << "Friendship added between '" << user1 << "' and '" << user2 << "'." << endl;
-    } else {
-        cout << "One or both users do not exist." << endl;
+// Returns the MinHash sketches, building them on first use and otherwise reindexing the users whose
+// signatures changed since the last query
+const MinHashSketches &SocialNetwork::cachedSketches() {
+    if (!sketchesEnabled) {
+        const uint32_t n = static_cast<uint32_t>(userNames.size());
+        sketches.resize(n);
+        parallelFor(n, 256, [&](size_t begin, size_t end, unsigned) {
+            for (size_t u = begin; u < end; ++u) sketches.assign(static_cast<uint32_t>(u), adjacency[u]);
+        });
+        sketches.buildIndex();
+        sketchesEnabled = true;
+        return sketches;
     }
+    vector<uint32_t> changed;
+    for (vector<uint32_t> &pending : pendingSketchUsers) {
+        changed.insert(changed.end(), pending.begin(), pending.end());
+        pending.clear();
+    }
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+    sketches.reindex(changed);
+    return sketches;
 }
 
-// Returns all friends of a specific user
-set<string> SocialNetwork::getFriends(const string &userName) const {
-    auto it = adj.find(userName);
-    if (it != adj.end()) {
-        return it->second;
+// Estimates the Jaccard similarity of two users' friend sets (shared friends over all friends of
+// either) from their sketches, without reading either friend list
+double SocialNetwork::estimateSimilarity(const string &user1, const string &user2) {
+    const uint32_t id1 = userIds.find(user1), id2 = userIds.find(user2);
+    if (id1 == NameIndex::kMissing || id2 == NameIndex::kMissing) {
+        cout << "Error: One or both users ('" << user1 << "', '" << user2 << "') not found for similarity estimate." << endl;
+        return 0.0;
     }
-    cout << "User '" << userName << "' not found." << endl;
-    return set<string>();
+    return cachedSketches().estimate(id1, id2);
 }
 
-// Displays the entire social network structure
-void SocialNetwork::printGraph() const {
-    cout << "\n--- Social Network Graph ---" << endl;
-    if (adj.empty()) {
-        cout << "The network is empty." << endl;
-        return;
+// Returns the k users (friends or not) whose friend sets are most similar to the user's, by
+// estimated Jaccard similarity. Candidates come from the LSH bands (32 bands of 2 minima), which
+// find a user with similarity 0.3 about 95% of the time (0.5: always) without scanning the network.
+vector<pair<string, double>> SocialNetwork::similarUsers(const string &userName, size_t k) {
+    vector<pair<string, double>> similar;
+    const uint32_t user = userIds.find(userName);
+    if (user == NameIndex::kMissing) {
+        cout << "Error: User '" << userName << "' not found for similar users." << endl;
+        return similar;
     }
-    for (const auto &pair : adj) {
-        cout << "'" << pair.first << "' is friends with: {";
-        string separator = "";
-        for (const string &friendName : pair.second) {
-            cout << separator << "'" << friendName << "'";
-            separator = ", ";
+
+    const MinHashSketches &index = cachedSketches();
+    vector<uint32_t> candidates;
+    index.candidates(user, candidates);
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    vector<pair<uint32_t, double>> scored;
+    for (uint32_t candidate : candidates) {
+        const double similarity = index.estimate(user, candidate);
+        if (similarity > 0.0) scored.emplace_back(candidate, similarity);
+    }
+    auto byScore = [this](const pair<uint32_t, double> &a, const pair<uint32_t, double> &b) {
+        if (a.second != b.second) {
+            return a.second > b.second;
         }
-        cout << "}" << endl;
+        return userNames[a.first] < userNames[b.first];
+    };
+    size_t top = min(k, scored.size());
+    std::partial_sort(scored.begin(), scored.begin() + top, scored.end(), byScore);
+
+    for (size_t i = 0; i < top; ++i) {
+        similar.emplace_back(string(userNames[scored[i].first]), scored[i].second);
     }
-    cout << "----------------------------\n" << endl;
+    return similar;
 }
 
-// Finds common friends between two users using set intersection
-set<string> SocialNetwork::getMutualFriends(const string &user1, const string &user2) {
-    set<string> mutualFriends;
-    auto it1 = adj.find(user1);
-    auto it2 = adj.find(user2);
+// Returns the name search index, merging in users added since it was built and refreshing degrees
+// after the graph changed
+const NameSearchIndex &SocialNetwork::cachedSearchIndex() {
+    getSnapshot(); // Clears searchDegreesValid when the graph changed
+    const uint32_t n = static_cast<uint32_t>(userNames.size());
+    if (searchIndex.byName.size() != n) {
+        searchIndex.addUsers(userNames.data(), n);
+        searchDegreesValid = false;
+    }
+    if (!searchDegreesValid) {
+        searchIndex.refreshDegrees([this](uint32_t id) { return static_cast<uint32_t>(adjacency[id].size()); });
+        searchDegreesValid = true;
+    }
+    return searchIndex;
+}
 
-    if (it1 == adj.end() || it2 == adj.end()) {
-        cout << "Error: One or both users ('" << user1 << "', '" << user2 << "') not found for mutual friends calculation." << endl;
-        return mutualFriends;
+// BFS from `source` (a user ID) out to 3 hops, returning (rank, hops) for the users it reaches whose
+// name rank is in [first, last), or in `ranks` (sorted) when given. Stops after the first level at
+// which `enough` matches have been found.
+vector<pair<uint32_t, int>> SocialNetwork::nearbyMatches(uint32_t source, uint32_t first, uint32_t last,
+                                                         const vector<uint32_t> *ranks, size_t enough) {
+    const int radius = 3;
+    const CSRGraph &g = getSnapshot();
+    vector<pair<uint32_t, int>> found;
+    pmr::vector<char> visited(g.numVertices(), 0, queryScratch());
+    pmr::vector<uint32_t> frontier(1, snapshotVertex[source], queryScratch()), next(queryScratch());
+    visited[frontier[0]] = 1;
+    for (int hops = 0; hops <= radius && !frontier.empty() && found.size() < enough; ++hops) {
+        next.clear();
+        for (uint32_t v : frontier) {
+            const uint32_t rank = searchIndex.rankOf[snapshotOrder[v]];
+            if (ranks ? std::binary_search(ranks->begin(), ranks->end(), rank) : first <= rank && rank < last) {
+                found.emplace_back(rank, hops);
+            }
+            if (hops == radius) continue;
+            for (const uint32_t *neighbor = g.begin(v); neighbor != g.end(v); ++neighbor) {
+                if (!visited[*neighbor]) {
+                    visited[*neighbor] = 1;
+                    next.push_back(*neighbor);
+                }
+            }
+        }
+        frontier.swap(next);
     }
+    return found;
+}
 
-    const set<string> &friends1 = it1->second;
-    const set<string> &friends2 = it2->second;
+UserSearchHit SocialNetwork::searchHit(uint32_t rank, int distance, int edits) const {
+    return {string(userNames[searchIndex.byName[rank]]), searchIndex.degrees[rank], distance, edits};
+}
 
-    // Find intersection of two friend sets
-    std::set_intersection(friends1.begin(), friends1.end(), friends2.begin(), friends2.end(), 
-                          std::inserter(mutualFriends, mutualFriends.begin()));
-    return mutualFriends;
+// Autocompletes a name prefix. Ranked by degree, the top users of the matching name range come
+// from the index's block maxima. Ranked by distance, matches are collected by BFS around the
+// searching user (up to 3 hops) and the rest of the list is filled by degree.
+vector<UserSearchHit> SocialNetwork::searchUsers(const string &prefix, size_t limit, SearchRanking ranking,
+                                                 const string &searcher) {
+    vector<UserSearchHit> hits;
+    const uint32_t source = userIds.find(searcher);
+    if (ranking == SearchRanking::Distance && source == NameIndex::kMissing) {
+        cout << "Error: Searching user '" << searcher << "' not found." << endl;
+        return hits;
+    }
+    const NameSearchIndex &index = cachedSearchIndex();
+    const pair<uint32_t, uint32_t> range = index.prefixRange(userNames.data(), prefix);
+
+    vector<pair<uint32_t, int>> nearby;
+    if (ranking == SearchRanking::Distance) {
+        nearby = nearbyMatches(source, range.first, range.second, nullptr, limit);
+        std::sort(nearby.begin(), nearby.end(), [&index](const pair<uint32_t, int> &a, const pair<uint32_t, int> &b) {
+            if (a.second != b.second) return a.second < b.second;
+            if (index.degrees[a.first] != index.degrees[b.first]) return index.degrees[a.first] > index.degrees[b.first];
+            return a.first < b.first;
+        });
+        if (nearby.size() > limit) nearby.resize(limit);
+        for (const auto &match : nearby) hits.push_back(searchHit(match.first, match.second, 0));
+    }
+    std::sort(nearby.begin(), nearby.end());
+    auto alreadyHit = [&nearby](uint32_t rank) {
+        return std::binary_search(nearby.begin(), nearby.end(), make_pair(rank, 0),
+                                  [](const pair<uint32_t, int> &a, const pair<uint32_t, int> &b) { return a.first < b.first; });
+    };
+    for (uint32_t rank : index.topByDegree(range.first, range.second, limit - hits.size(), alreadyHit)) {
+        hits.push_back(searchHit(rank, -1, 0));
+    }
+    return hits;
 }
 
-// Suggests potential friends based on mutual connections (friend-of-friend algorithm)
-vector<pair<string, int>> SocialNetwork::suggestFriends(const string &userName) {
-    map<string, int> suggestionCounts;
-    vector<pair<string, int>> sortedSuggestions;
+// Finds names within maxEdits insertions, deletions or substitutions of the query. Results are
+// ordered by edit distance, then by degree or by hops from the searching user (matches farther than
+// 3 hops come after the nearby ones).
+vector<UserSearchHit> SocialNetwork::fuzzySearchUsers(const string &query, int maxEdits, size_t limit,
+                                                      SearchRanking ranking, const string &searcher) {
+    vector<UserSearchHit> hits;
+    const uint32_t source = userIds.find(searcher);
+    if (ranking == SearchRanking::Distance && source == NameIndex::kMissing) {
+        cout << "Error: Searching user '" << searcher << "' not found." << endl;
+        return hits;
+    }
+    const NameSearchIndex &index = cachedSearchIndex();
+    vector<pair<uint32_t, int>> matches; // (rank, edits), in rank order
+    index.fuzzyMatches(userNames.data(), query, maxEdits, matches);
 
-    auto it = adj.find(userName);
-    if (it == adj.end()) {
-        cout << "Error: User '" << userName << "' not found for friend suggestions." << endl;
-        return sortedSuggestions;
+    vector<int> distance(matches.size(), -1);
+    if (ranking == SearchRanking::Distance && !matches.empty()) {
+        vector<uint32_t> ranks(matches.size());
+        for (size_t i = 0; i < matches.size(); ++i) ranks[i] = matches[i].first;
+        for (const auto &match : nearbyMatches(source, 0, 0, &ranks, ranks.size())) {
+            distance[std::lower_bound(ranks.begin(), ranks.end(), match.first) - ranks.begin()] = match.second;
+        }
     }
 
-    const set<string> &directFriends = it->second;
+    vector<size_t> order(matches.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    auto better = [&](size_t a, size_t b) {
+        if (matches[a].second != matches[b].second) return matches[a].second < matches[b].second;
+        if (distance[a] != distance[b]) return static_cast<unsigned>(distance[a]) < static_cast<unsigned>(distance[b]); // -1 last
+        if (index.degrees[matches[a].first] != index.degrees[matches[b].first]) {
+            return index.degrees[matches[a].first] > index.degrees[matches[b].first];
+        }
+        return matches[a].first < matches[b].first;
+    };
+    const size_t count = min(limit, order.size());
+    std::partial_sort(order.begin(), order.begin() + count, order.end(), better);
+    for (size_t i = 0; i < count; ++i) hits.push_back(searchHit(matches[order[i]].first, distance[order[i]], matches[order[i]].second));
+    return hits;
+}
 
-    // Iterate through each direct friend
-    for (const string &friendName : directFriends) {
-        auto friendIt = adj.find(friendName);
-        if (friendIt == adj.end()) continue;
+// Builds a synthetic clustered network for benchmarks: users belong to communities of ~100 and most
+// friendships stay inside a community, but users are added in random order so insertion IDs scatter.
+void buildSyntheticNetwork(SocialNetwork &net, uint32_t users, uint32_t friendsPerUser, uint64_t seed,
+                           size_t batchSize = 0) {
+    // Silence the per-call messages printed by addUser / addFriendship
+    stringstream sink;
+    streambuf *console = cout.rdbuf(sink.rdbuf());
 
-        // Look at friends-of-friends
-        for (const string &potentialFriend : friendIt->second) {
-            if (potentialFriend != userName && directFriends.find(potentialFriend) == directFriends.end()) {
-                if (adj.count(potentialFriend)) {
-                    suggestionCounts[potentialFriend]++;
-                }
+    vector<uint32_t> insertion = samplePivots(users, users, seed);
+    for (uint32_t id : insertion) {
+        net.addUser("user" + to_string(id));
+        sink.str("");
+    }
+    FastRng rng(seed + 1);
+    const uint32_t communitySize = 100;
+    vector<EdgeUpdate> batch;
+    for (uint32_t u = 0; u < users; ++u) {
+        for (uint32_t i = 0; i < friendsPerUser / 2; ++i) {
+            uint32_t v = rng.below(10) < 8 ? (u / communitySize) * communitySize + rng.below(communitySize)
+                                           : rng.below(users);
+            if (v >= users || v == u) continue;
+            if (batchSize == 0) {
+                net.addFriendship("user" + to_string(u), "user" + to_string(v));
+                continue;
+            }
+            batch.push_back({"user" + to_string(u), "user" + to_string(v)});
+            if (batch.size() == batchSize) {
+                net.applyBatch(batch);
+                batch.clear();
             }
         }
+        sink.str("");
     }
+    if (!batch.empty()) net.applyBatch(batch);
+    cout.rdbuf(console);
+}
 
-    // Convert to vector for sorting
-    for (const auto &pair : suggestionCounts) {
-        sortedSuggestions.push_back(pair);
-    }
+// Times shortestPathBFS and suggestFriends on the same queries under every reorder strategy
+void benchmarkReordering(SocialNetwork &net, uint32_t users, uint32_t queries) {
+    const pair<ReorderStrategy, const char *> strategies[] = {
+        {ReorderStrategy::None, "insertion order"},
+        {ReorderStrategy::DegreeDescending, "degree descending"},
+        {ReorderStrategy::BFS, "BFS order"},
+        {ReorderStrategy::ReverseCuthillMcKee, "reverse Cuthill-McKee"},
+        {ReorderStrategy::Gorder, "Gorder"}};
+    using Clock = chrono::steady_clock;
+    auto millis = [](Clock::duration d) { return chrono::duration<double, milli>(d).count(); };
 
-    // Sort by number of mutual connections (descending) and name (ascending)
-    std::sort(sortedSuggestions.begin(), sortedSuggestions.end(),
-              [](const pair<string, int> &a, const pair<string, int> &b) {
-                  if (a.second != b.second) {
-                      return a.second > b.second;
-                  }
-                  return a.first < b.first;
-              });
+    cout << left << setw(24) << "  Strategy" << right << setw(12) << "build (ms)" << setw(12) << "BFS (ms)" << setw(14)
+         << "suggest (ms)" << endl;
+    for (const auto &strategy : strategies) {
+        net.setReorderStrategy(strategy.first);
+        Clock::time_point t0 = Clock::now();
+        net.getSnapshot();
+        Clock::time_point t1 = Clock::now();
 
-    return sortedSuggestions;
+        FastRng rng(42); // Same query mix for every strategy
+        size_t checksum = 0;
+        for (uint32_t q = 0; q < queries; ++q) {
+            checksum += net.shortestPathBFS("user" + to_string(rng.below(users)), "user" + to_string(rng.below(users))).first;
+        }
+        Clock::time_point t2 = Clock::now();
+        for (uint32_t q = 0; q < queries; ++q) {
+            checksum += net.suggestFriends("user" + to_string(rng.below(users))).size();
+        }
+        Clock::time_point t3 = Clock::now();
+
+        cout << "  " << left << setw(22) << strategy.second << right << fixed << setprecision(1) << setw(12)
+             << millis(t1 - t0) << setw(12) << millis(t2 - t1) << setw(14) << millis(t3 - t2) << "   (checksum "
+             << checksum << ")" << defaultfloat << endl;
+    }
+    net.setReorderStrategy(ReorderStrategy::None);
 }
 
-// Finds shortest path between users using Breadth-First Search
-pair<int, list<string>> SocialNetwork::shortestPathBFS(const string &startUser, const string &endUser) {
-    list<string> path;
-    int distance = -1; // -1 indicates no path found
+// Compares memory footprint, BFS and intersection speed of the plain and compressed snapshots
+void benchmarkCompression(SocialNetwork &net, uint32_t queries) {
+    using Clock = chrono::steady_clock;
+    auto millis = [](Clock::duration d) { return chrono::duration<double, milli>(d).count(); };
+    const CSRGraph &g = net.getSnapshot();
+    CompressedCSRGraph compressed = net.getCompressedSnapshot();
+    const uint32_t n = g.numVertices();
 
-    // Validate input users exist
-    if (adj.find(startUser) == adj.end()) {
-        cout << "Error: Start user '" << startUser << "' not found for BFS." << endl;
-        return {distance, path};
-    }
-    if (adj.find(endUser) == adj.end()) {
-        cout << "Error: End user '" << endUser << "' not found for BFS." << endl;
-        return {distance, path};
-    }
+    size_t plainBytes = g.neighbors.size() * sizeof(uint32_t) + g.offsets.size() * sizeof(uint64_t);
+    cout << "  Plain CSR:      " << fixed << setprecision(2) << double(plainBytes) / g.numArcs() << " bytes/arc" << endl;
+    cout << "  Compressed CSR: " << double(compressed.bytesUsed()) / g.numArcs() << " bytes/arc" << endl;
 
-    // Special case: path to self
-    if (startUser == endUser) {
-        path.push_back(startUser);
-        return {0, path};
-    }
+    FastRng rng(9);
+    vector<pair<uint32_t, uint32_t>> pairs(queries);
+    for (auto &p : pairs) p = {rng.below(n), rng.below(n)};
+    size_t plainSum = 0, compressedSum = 0;
 
-    // BFS algorithm implementation
-    queue<string> q;
-    map<string, string> parent; // For path reconstruction
-    map<string, int> dist;      // Track distances
+    Clock::time_point t0 = Clock::now();
+    for (const auto &p : pairs) {
+        const uint32_t unvisited = numeric_limits<uint32_t>::max();
+        vector<uint32_t> parent(n, unvisited), frontier{p.first};
+        parent[p.first] = p.first;
+        for (size_t head = 0; head < frontier.size() && parent[p.second] == unvisited; ++head) {
+            for (const uint32_t *v = g.begin(frontier[head]); v != g.end(frontier[head]); ++v) {
+                if (parent[*v] == unvisited) {
+                    parent[*v] = frontier[head];
+                    frontier.push_back(*v);
+                }
+            }
+        }
+        plainSum += frontier.size() > 0;
+    }
+    Clock::time_point t1 = Clock::now();
+    for (const auto &p : pairs) compressedSum += !compressedShortestPath(compressed, p.first, p.second).empty();
+    Clock::time_point t2 = Clock::now();
+    cout << "  BFS:          plain " << millis(t1 - t0) << " ms, compressed " << millis(t2 - t1) << " ms" << endl;
 
-    // Initialize distances
-    for (const auto &pair : adj) {
-        dist[pair.first] = -1; // -1 means unvisited
-        parent[pair.first] = "";
+    vector<uint32_t> common;
+    t0 = Clock::now();
+    for (uint32_t q = 0; q < queries * 500; ++q) {
+        const auto &p = pairs[q % queries];
+        uint32_t u = p.first, v = g.neighbors.empty() ? p.second : g.neighbors[g.offsets[p.first] % g.numArcs()];
+        common.clear();
+        std::set_intersection(g.begin(u), g.end(u), g.begin(v), g.end(v), back_inserter(common));
+        plainSum += common.size();
+    }
+    t1 = Clock::now();
+    for (uint32_t q = 0; q < queries * 500; ++q) {
+        const auto &p = pairs[q % queries];
+        uint32_t u = p.first, v = g.neighbors.empty() ? p.second : g.neighbors[g.offsets[p.first] % g.numArcs()];
+        compressedSum += compressedIntersection(compressed, u, v).size();
     }
+    t2 = Clock::now();
+    cout << "  Intersection: plain " << millis(t1 - t0) << " ms, compressed " << millis(t2 - t1) << " ms"
+         << defaultfloat << endl;
+}
 
-    // Start BFS from startUser
-    q.push(startUser);
-    dist[startUser] = 0;
+// Reports the WebGraph codec's footprint and times a full-graph BFS made of sequential passes
+void benchmarkWebGraph(SocialNetwork &net) {
+    using Clock = chrono::steady_clock;
+    auto millis = [](Clock::duration d) { return chrono::duration<double, milli>(d).count(); };
+    Clock::time_point t0 = Clock::now();
+    WebGraphCompressed compressed = net.getWebGraphSnapshot();
+    Clock::time_point t1 = Clock::now();
+    vector<int32_t> dist = webGraphBFS(compressed, 0);
+    Clock::time_point t2 = Clock::now();
+    int32_t depth = *max_element(dist.begin(), dist.end());
+    cout << "  WebGraph: " << fixed << setprecision(2) << double(compressed.bytesUsed()) / compressed.arcs
+         << " bytes/arc, compress " << millis(t1 - t0) << " ms, full BFS (" << depth + 1 << " passes) "
+         << millis(t2 - t1) << " ms" << defaultfloat << endl;
+}
 
-    bool found = false;
-    while (!q.empty() && !found) {
-        string currentUser = q.front();
-        q.pop();
+// Name search: index build, then prefix and one-edit fuzzy queries ranked by degree and by distance
+void benchmarkUserSearch(SocialNetwork &net, uint32_t users, uint32_t queries) {
+    auto t0 = chrono::steady_clock::now();
+    net.searchUsers("", 1); // Builds the index
+    auto t1 = chrono::steady_clock::now();
 
-        // Explore all neighbors
-        for (const string &neighbor : adj.at(currentUser)) {
-            if (dist.count(neighbor) && dist[neighbor] == -1) {
-                dist[neighbor] = dist[currentUser] + 1;
-                parent[neighbor] = currentUser;
-                q.push(neighbor);
-
-                if (neighbor == endUser) {
-                    found = true;
-                    distance = dist[neighbor];
-                    break;
-                }
+    FastRng rng(19);
+    size_t checksum = 0;
+    vector<double> millis;
+    for (int kind = 0; kind < 4; ++kind) {
+        auto start = chrono::steady_clock::now();
+        for (uint32_t q = 0; q < queries; ++q) {
+            string name = "user" + to_string(rng.below(users));
+            SearchRanking ranking = kind % 2 ? SearchRanking::Distance : SearchRanking::Degree;
+            string searcher = "user" + to_string(rng.below(users));
+            if (kind < 2) {
+                checksum += net.searchUsers(name.substr(0, 6), 10, ranking, searcher).size();
+            } else {
+                name.erase(4 + rng.below(name.size() - 4), 1); // Drop one digit
+                checksum += net.fuzzySearchUsers(name, 1, 10, ranking, searcher).size();
             }
         }
+        millis.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / queries);
     }
+    cout << fixed << setprecision(3) << "  index build " << chrono::duration<double, milli>(t1 - t0).count()
+         << " ms; per query: prefix " << millis[0] << " ms (by degree), " << millis[1] << " ms (by distance); fuzzy "
+         << millis[2] << " ms (by degree), " << millis[3] << " ms (by distance) [" << checksum << " hits]" << endl;
+}
 
-    // Reconstruct path if one was found
-    if (found) {
-        string current = endUser;
-        while (!current.empty()) {
-            path.push_front(current);
-            current = parent[current];
+// Whole-graph traversals with the level-synchronous parallel BFS, in traversed arcs per second
+void benchmarkParallelBFS(SocialNetwork &net, uint32_t users, uint32_t sources) {
+    const CSRGraph &g = net.getSnapshot();
+    FastRng rng(37);
+    size_t reached = 0;
+    auto start = chrono::steady_clock::now();
+    for (uint32_t s = 0; s < sources; ++s) {
+        for (uint32_t count : net.hopCounts("user" + to_string(rng.below(users)))) reached += count;
+    }
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << fixed << setprecision(1) << "  " << workerCount() << " threads: " << seconds * 1000 / sources
+         << " ms per traversal, " << double(g.numArcs()) * sources / seconds / 1e6 << " M arcs/s [" << reached
+         << " users reached]" << endl;
+}
+
+// k shortest paths (Yen) between random users: time per query and average length of the paths
+void benchmarkKShortestPaths(SocialNetwork &net, uint32_t users, uint32_t queries, size_t k) {
+    FastRng rng(41);
+    size_t found = 0, hops = 0;
+    auto start = chrono::steady_clock::now();
+    for (uint32_t q = 0; q < queries; ++q) {
+        for (const list<string> &path : net.kShortestPaths("user" + to_string(rng.below(users)),
+                                                           "user" + to_string(rng.below(users)), k)) {
+            ++found;
+            hops += path.size() - 1;
         }
-    } else {
-        cout << "BFS: No path found between '" << startUser << "' and '" << endUser << "'." << endl;
     }
+    const double millis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << fixed << setprecision(2) << "  k = " << k << ": " << millis / queries << " ms per query, " << found
+         << " paths of " << (found ? double(hops) / found : 0.0) << " hops on average" << endl;
+}
 
-    return {distance, path};
+// Shortest-path counting between random users with 5 sampled paths each
+void benchmarkPathCounting(SocialNetwork &net, uint32_t users, uint32_t queries) {
+    FastRng rng(43);
+    double hops = 0.0, paths = 0.0;
+    size_t connected = 0, samples = 0;
+    auto start = chrono::steady_clock::now();
+    for (uint32_t q = 0; q < queries; ++q) {
+        ShortestPathCount result = net.countShortestPaths("user" + to_string(rng.below(users)),
+                                                          "user" + to_string(rng.below(users)), 5);
+        if (result.distance < 0) continue;
+        ++connected;
+        hops += result.distance;
+        paths += double(result.count);
+        samples += result.samples.size();
+    }
+    const double millis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << fixed << setprecision(2) << "  " << millis / queries << " ms per query; " << connected << " connected pairs, "
+         << (connected ? hops / connected : 0.0) << " hops and " << (connected ? paths / connected : 0.0)
+         << " shortest paths on average [" << samples << " sampled paths]" << endl;
 }
 
-// Finds shortest path using Dijkstra's algorithm (optimal for weighted graphs)
-pair<int, list<string>> SocialNetwork::shortestPathDijkstra(const string &startUser, const string &endUser) {
-    list<string> path;
-    int finalDistance = -1; // Default: no path found
+// Times one similarity scorer on the given query users, returning milliseconds per query
+template <typename Scorer>
+double timeSimilarityQueries(SocialNetwork &net, const vector<string> &queryUsers, size_t &checksum) {
+    auto start = chrono::steady_clock::now();
+    for (const string &name : queryUsers) checksum += net.suggestFriendsBy<Scorer>(name, 10).size();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / queryUsers.size();
+}
 
-    // Validate input users exist
-    if (adj.find(startUser) == adj.end()) {
-        cout << "Error: Start user '" << startUser << "' not found for Dijkstra." << endl;
-        return {finalDistance, path};
+// Per-query time of each link-prediction scorer on the same users
+void benchmarkSimilarity(SocialNetwork &net, uint32_t users, uint32_t queries) {
+    FastRng rng(23);
+    vector<string> queryUsers;
+    for (uint32_t q = 0; q < queries; ++q) queryUsers.push_back("user" + to_string(rng.below(users)));
+    size_t checksum = 0;
+    net.suggestFriendsBy<MutualFriendsScore>(queryUsers[0], 10); // Builds the degree tables
+    cout << fixed << setprecision(3) << "  per query: common neighbors "
+         << timeSimilarityQueries<MutualFriendsScore>(net, queryUsers, checksum) << " ms, Jaccard "
+         << timeSimilarityQueries<JaccardScore>(net, queryUsers, checksum) << " ms, cosine "
+         << timeSimilarityQueries<CosineScore>(net, queryUsers, checksum) << " ms, Adamic-Adar "
+         << timeSimilarityQueries<AdamicAdarScore>(net, queryUsers, checksum) << " ms, resource allocation "
+         << timeSimilarityQueries<ResourceAllocationScore>(net, queryUsers, checksum) << " ms [" << checksum
+         << " suggestions]" << endl;
+}
+
+// MinHash sketch build and update cost, query speed, and estimate error against exact Jaccard
+void benchmarkMinHash(SocialNetwork &net, uint32_t users, uint32_t queries) {
+    FastRng rng(29);
+    auto t0 = chrono::steady_clock::now();
+    net.estimateSimilarity("user0", "user1"); // Builds the sketches and LSH bands
+    auto t1 = chrono::steady_clock::now();
+    vector<EdgeUpdate> batch;
+    for (uint32_t i = 0; i < 10000; ++i) {
+        batch.push_back({"user" + to_string(rng.below(users)), "user" + to_string(rng.below(users))});
     }
-    if (adj.find(endUser) == adj.end()) {
-        cout << "Error: End user '" << endUser << "' not found for Dijkstra." << endl;
-        return {finalDistance, path};
+    net.applyBatch(batch);
+    auto t2 = chrono::steady_clock::now();
+    net.estimateSimilarity("user0", "user1"); // Reindexes the changed users
+    auto t3 = chrono::steady_clock::now();
+
+    size_t checksum = 0;
+    for (uint32_t q = 0; q < queries; ++q) checksum += net.similarUsers("user" + to_string(rng.below(users)), 10).size();
+    auto t4 = chrono::steady_clock::now();
+
+    // Error on pairs with shared friends, where exact scores are cheap to get
+    double error = 0.0;
+    size_t pairs = 0;
+    for (uint32_t q = 0; q < queries; ++q) {
+        const string name = "user" + to_string(rng.below(users));
+        for (const auto &exact : net.suggestFriendsBy<JaccardScore>(name, 5)) {
+            error += fabs(net.estimateSimilarity(name, exact.first) - exact.second);
+            ++pairs;
+        }
     }
+    cout << fixed << setprecision(3) << "  sketch build " << chrono::duration<double, milli>(t1 - t0).count()
+         << " ms; 10000-update batch " << chrono::duration<double, milli>(t2 - t1).count() << " ms + reindex "
+         << chrono::duration<double, milli>(t3 - t2).count() << " ms; similarUsers "
+         << chrono::duration<double, milli>(t4 - t3).count() / queries << " ms per query [" << checksum
+         << " results]; mean error " << (pairs ? error / pairs : 0.0) << " over " << pairs << " pairs" << endl;
+}
 
-    // Special case: path to self
-    if (startUser == endUser) {
-        path.push_back(startUser);
-        return {0, path};
+// Measured false-positive rate of the friendship filter at several targets, and the time of
+// areFriends and suggestFriends without and with it
+void benchmarkFriendshipFilter(SocialNetwork &net, uint32_t users, uint32_t queries) {
+    FastRng rng(31);
+    cout << "  false positives:" << fixed;
+    for (double rate : {0.1, 0.01, 0.001}) {
+        const uint32_t keys = 1000000;
+        FriendshipFilter filter;
+        filter.reset(keys, rate);
+        for (uint32_t i = 0; i < keys; ++i) filter.insert(i, i + keys);
+        uint32_t positives = 0;
+        for (uint32_t i = 0; i < keys; ++i) positives += filter.mayContain(rng.next() % keys, keys + 2 * keys + i);
+        cout << setprecision(4) << " target " << rate << " -> " << double(positives) / keys << setprecision(1) << " ("
+             << double(filter.bytes()) / keys << " bytes/friendship);";
     }
+    cout << endl;
 
-    // Dijkstra algorithm implementation
-    map<string, int> dist;          // Track shortest distance to each node
-    map<string, string> parent;     // For path reconstruction
-    priority_queue<pair<int, string>, vector<pair<int, string>>, greater<pair<int, string>>> pq; // Min-priority queue
+    vector<pair<string, string>> pairs;
+    for (uint32_t q = 0; q < 100 * queries; ++q) {
+        pairs.emplace_back("user" + to_string(rng.below(users)), "user" + to_string(rng.below(users)));
+    }
+    for (bool filtered : {false, true}) {
+        if (filtered) net.enableFriendshipFilter(0.01);
+        size_t friends = 0, suggestions = 0;
+        auto start = chrono::steady_clock::now();
+        for (const auto &pair : pairs) friends += net.areFriends(pair.first, pair.second);
+        auto middle = chrono::steady_clock::now();
+        for (uint32_t q = 0; q < queries; ++q) suggestions += net.suggestFriends(pairs[q].first).size();
+        auto end = chrono::steady_clock::now();
+        cout << fixed << setprecision(3) << "  " << (filtered ? "with filter:   " : "without filter:") << " areFriends "
+             << chrono::duration<double, micro>(middle - start).count() / pairs.size() << " us, suggestFriends "
+             << chrono::duration<double, milli>(end - middle).count() / queries << " ms [" << friends << " friends, "
+             << suggestions << " suggestions]" << endl;
+    }
+}
 
-    // Define INF constant for "infinity" distance
-    const int INF = numeric_limits<int>::max();
+// Benchmark driver, run with --bench
+// Bulk build, teardown through clear() (pool release), reload into the same network, and a reload
+// that ingests friendships through applyBatch
+void benchmarkBuildTeardown(uint32_t users) {
+    SocialNetwork net;
+    const pair<const char *, size_t> phases[] = {{"build", 0}, {"reload", 0}, {"batched", 4096}};
+    for (const auto &[phase, batchSize] : phases) {
+        auto t0 = chrono::steady_clock::now();
+        buildSyntheticNetwork(net, users, 20, 7, batchSize);
+        auto t1 = chrono::steady_clock::now();
+        net.clear();
+        auto t2 = chrono::steady_clock::now();
+        cout << "  " << left << setw(8) << phase << right << fixed << setprecision(1)
+             << chrono::duration<double, milli>(t1 - t0).count() << " ms, teardown "
+             << chrono::duration<double, milli>(t2 - t1).count() << " ms" << endl;
+    }
+}
 
-    // Initialize distances
-    for (const auto &pair : adj) {
-        dist[pair.first] = INF; // INF means infinity (unreachable initially)
-        parent[pair.first] = "";
+// Throughput of updateFriendship called concurrently from every worker thread
+void benchmarkConcurrentUpdates(uint32_t users) {
+    SocialNetwork net;
+    buildSyntheticNetwork(net, users, 0, 7); // Users only
+    FastRng rng(11);
+    vector<EdgeUpdate> updates;
+    for (uint32_t u = 0; u < users; ++u) {
+        for (int i = 0; i < 10; ++i) {
+            uint32_t v = rng.below(10) < 8 ? (u / 100) * 100 + rng.below(100) : rng.below(users);
+            if (v < users && v != u) updates.push_back({"user" + to_string(u), "user" + to_string(v)});
+        }
+    }
+    for (EdgeUpdate::Kind kind : {EdgeUpdate::Kind::Add, EdgeUpdate::Kind::Remove}) {
+        for (EdgeUpdate &update : updates) update.kind = kind;
+        auto t0 = chrono::steady_clock::now();
+        parallelFor(updates.size(), 4096, [&](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; ++i) net.updateFriendship(updates[i]);
+        });
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        cout << "  concurrent " << (kind == EdgeUpdate::Kind::Add ? "inserts: " : "deletes: ") << fixed
+             << setprecision(2) << updates.size() / seconds / 1e6 << " M/s (" << workerCount() << " threads)" << endl;
     }
+}
 
-    // Start with startUser
-    dist[startUser] = 0;
-    pq.push({0, startUser});
+// Name index: addUser from every worker thread at once, then resolving names to IDs with batched
+// lookupIds, against a std::unordered_map over the same names
+void benchmarkNameIndex(uint32_t users) {
+    vector<string> names(users);
+    for (uint32_t id : samplePivots(users, users, 5)) names[id] = "user" + to_string(id);
 
-    bool found = false;
-    while (!pq.empty()) {
-        int d = pq.top().first;
-        string u = pq.top().second;
-        pq.pop();
+    SocialNetwork net;
+    cout.setstate(ios::badbit); // Drop addUser's messages; a shared string sink would race
+    auto t0 = chrono::steady_clock::now();
+    parallelFor(users, 1024, [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; ++i) net.addUser(names[i]);
+    });
+    auto t1 = chrono::steady_clock::now();
+    cout.clear();
 
-        // Skip outdated entries in priority queue
-        if (d > dist[u]) {
-            continue;
-        }
+    FastRng rng(17);
+    vector<string_view> queries(4 * size_t(users));
+    for (string_view &query : queries) query = names[rng.below(users)];
+    vector<uint32_t> ids = net.lookupIds(vector<string_view>(names.begin(), names.end()));
+    unordered_map<string_view, uint32_t> reference;
+    for (uint32_t i = 0; i < users; ++i) reference.emplace(names[i], ids[i]);
+    uint64_t checksum = 0;
+    auto t2 = chrono::steady_clock::now();
+    for (string_view query : queries) checksum += reference.find(query)->second;
+    auto t3 = chrono::steady_clock::now();
+    ids = net.lookupIds(queries);
+    for (uint32_t id : ids) checksum -= id;
+    auto t4 = chrono::steady_clock::now();
 
-        // Check if we've reached the destination
-        if (u == endUser) {
-            found = true;
-            finalDistance = dist[u];
-            break;
-        }
+    auto rate = [&](chrono::steady_clock::duration d) { return queries.size() / chrono::duration<double>(d).count() / 1e6; };
+    cout << fixed << setprecision(1) << "  concurrent addUser " << chrono::duration<double, milli>(t1 - t0).count()
+         << " ms (" << workerCount() << " threads), lookups: unordered_map " << rate(t3 - t2) << " M/s, lookupIds "
+         << rate(t4 - t3) << " M/s" << (checksum == 0 ? "" : " (ID MISMATCH)") << endl;
+}
 
-        // Explore all neighbors
-        for (const string &v : adj.at(u)) {
-            int weight = 1; // Assuming unweighted graph (each edge has weight 1)
+// Cost of MVCC versions: the initial build, per-batch commits, and flattening a pinned version to CSR
+void benchmarkVersioning(uint32_t users) {
+    SocialNetwork net;
+    buildSyntheticNetwork(net, users, 20, 7);
+    auto t0 = chrono::steady_clock::now();
+    net.enableVersioning();
+    auto t1 = chrono::steady_clock::now();
+    shared_ptr<const GraphVersion> first = net.pinVersion();
 
-            if (dist.count(v)) {
-                // Relaxation step: if we found a shorter path to v through u
-                if (dist[u] != INF && dist[u] + weight < dist[v]) {
-                    dist[v] = dist[u] + weight;
-                    parent[v] = u;
-                    pq.push({dist[v], v});
-                }
-            }
+    FastRng rng(13);
+    const int batches = 50;
+    vector<EdgeUpdate> batch;
+    for (int b = 0; b < batches; ++b) {
+        batch.clear();
+        for (int i = 0; i < 4096; ++i) {
+            batch.push_back({"user" + to_string(rng.below(users)), "user" + to_string(rng.below(users)),
+                             rng.below(4) == 0 ? EdgeUpdate::Kind::Remove : EdgeUpdate::Kind::Add});
         }
+        net.applyBatch(batch); // Commits one version per batch
     }
+    auto t2 = chrono::steady_clock::now();
+    CSRGraph flat = materializeVersion(*first);
+    auto t3 = chrono::steady_clock::now();
 
-    // Reconstruct path if one was found
-    if (found) {
-        string current = endUser;
-        while (!current.empty()) {
-            path.push_front(current);
-            if (parent.find(current) == parent.end() || parent[current].empty()) break;
-            current = parent[current];
-        }
-    } else {
-        cout << "Dijkstra: No path found between '" << startUser << "' and '" << endUser << "'." << endl;
-    }
+    auto millis = [](chrono::steady_clock::duration d) { return chrono::duration<double, milli>(d).count(); };
+    cout << fixed << setprecision(1) << "  enable " << millis(t1 - t0) << " ms, " << batches
+         << " batches of 4096 updates " << millis(t2 - t1) / batches << " ms each, materialize version "
+         << first->number << " " << millis(t3 - t2) << " ms (" << flat.numArcs() << " arcs, latest is version "
+         << net.pinVersion()->number << ")" << endl;
+}
 
-    return {finalDistance, path};
+void runBenchmarks() {
+    const uint32_t users = 200000;
+    cout << "--- Benchmark: Build / Teardown (" << users << " users) ---" << endl;
+    benchmarkBuildTeardown(users);
+    benchmarkConcurrentUpdates(users);
+    benchmarkNameIndex(users);
+
+    cout << "\n--- Benchmark: Versioned Snapshots ---" << endl;
+    benchmarkVersioning(users);
+
+    cout << "\n--- Benchmark: Graph Reordering (" << users << " users) ---" << endl;
+    SocialNetwork net;
+    buildSyntheticNetwork(net, users, 20, 7);
+    benchmarkReordering(net, users, 200);
+
+    cout << "\n--- Benchmark: Parallel BFS ---" << endl;
+    benchmarkParallelBFS(net, users, 20);
+
+    cout << "\n--- Benchmark: k Shortest Paths ---" << endl;
+    benchmarkKShortestPaths(net, users, 50, 10);
+
+    cout << "\n--- Benchmark: Shortest Path Counting ---" << endl;
+    benchmarkPathCounting(net, users, 200);
+
+    cout << "\n--- Benchmark: User Search ---" << endl;
+    benchmarkUserSearch(net, users, 200);
+
+    cout << "\n--- Benchmark: Similarity Scorers ---" << endl;
+    benchmarkSimilarity(net, users, 500);
+
+    cout << "\n--- Benchmark: Friendship Filter ---" << endl;
+    benchmarkFriendshipFilter(net, users, 200);
+
+    cout << "\n--- Benchmark: Compressed Snapshot ---" << endl;
+    net.setReorderStrategy(ReorderStrategy::BFS); // Locality also shrinks the gaps
+    benchmarkCompression(net, 200);
+    benchmarkWebGraph(net);
+    net.setReorderStrategy(ReorderStrategy::None);
+
+    cout << "\n--- Benchmark: MinHash Similarity ---" << endl;
+    benchmarkMinHash(net, users, 500); // Last: its update batch changes the graph
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        runBenchmarks();
+        return 0;
+    }
+
     cout << "--- Social Network Simulation ---" << endl;
     SocialNetwork net;
 
@@ -507,6 +6113,461 @@ int main() {
         cout << "  Error: Path found unexpectedly!" << endl;
     }
 
+    // Test global PageRank influence scores
+    cout << "\n--- Testing: PageRank ---" << endl;
+    vector<pair<string, double>> ranks = net.pageRank();
+    for (const auto &entry : ranks) {
+        cout << "  - '" << entry.first << "': " << entry.second << endl;
+    }
+
+    // Test personalized PageRank suggestions
+    cout << "\n--- Testing: Suggest Friends (Personalized PageRank) ---" << endl;
+    userToQuery = "Alice";
+    vector<pair<string, double>> pprSuggestions = net.suggestFriendsPPR(userToQuery, 3);
+    cout << "PPR friend suggestions for '" << userToQuery << "':" << endl;
+    if (pprSuggestions.empty()) {
+        cout << "  None." << endl;
+    } else {
+        for (const auto &suggestion : pprSuggestions) {
+            cout << "  - '" << suggestion.first << "' (score " << suggestion.second << ")" << endl;
+        }
+    }
+
+    // Test random-walk-with-restart suggestions (visit frequency per walk step)
+    cout << "\n--- Testing: Suggest Friends (Random Walk with Restart) ---" << endl;
+    userToQuery = "Bob";
+    vector<pair<string, double>> walkSuggestions = net.suggestFriendsRandomWalk(userToQuery, 3, 20000);
+    cout << "Random walk friend suggestions for '" << userToQuery << "':" << endl;
+    if (walkSuggestions.empty()) {
+        cout << "  None." << endl;
+    } else {
+        for (const auto &suggestion : walkSuggestions) {
+            cout << "  - '" << suggestion.first << "' (visit rate " << suggestion.second << ")" << endl;
+        }
+    }
+
+    // Test exact and sampled betweenness centrality
+    cout << "\n--- Testing: Betweenness Centrality ---" << endl;
+    pair<double, vector<pair<string, double>>> betweenness = net.betweennessCentrality();
+    cout << "Exact betweenness:" << endl;
+    for (const auto &entry : betweenness.second) {
+        cout << "  - '" << entry.first << "': " << entry.second << endl;
+    }
+    betweenness = net.betweennessCentrality(4);
+    cout << "Sampled betweenness (4 pivots, +/- " << betweenness.first << " at 95% confidence), top 3:" << endl;
+    for (size_t i = 0; i < 3 && i < betweenness.second.size(); ++i) {
+        cout << "  - '" << betweenness.second[i].first << "': " << betweenness.second[i].second << endl;
+    }
+
+    // Test HyperANF neighborhood function, reach and effective diameter
+    cout << "\n--- Testing: Neighborhood Function (HyperANF) ---" << endl;
+    vector<double> nf = net.neighborhoodFunction();
+    for (size_t t = 0; t < nf.size(); ++t) {
+        cout << "  N(" << t << ") ~ " << nf[t] << endl;
+    }
+    vector<pair<string, double>> reach = net.reachEstimates(2);
+    cout << "Users within 2 hops of '" << reach.front().first << "': ~" << reach.front().second << endl;
+    cout << "Effective diameter (90%): " << net.effectiveDiameter() << endl;
+    vector<uint32_t> hops = net.hopCounts("Alice");
+    cout << "Users by exact distance from 'Alice' (parallel BFS):";
+    for (size_t h = 0; h < hops.size(); ++h) cout << " " << h << ":" << hops[h];
+    cout << endl;
+    net.hopCounts("Nobody");
+
+    // Test k-core decomposition (sequential and parallel peeling must agree)
+    cout << "\n--- Testing: k-Core Decomposition ---" << endl;
+    for (const auto &entry : net.coreNumbers()) {
+        cout << "  - '" << entry.first << "': core " << entry.second << endl;
+    }
+    if (computeCoreNumbers(net.getSnapshot()) != computeCoreNumbersParallel(net.getSnapshot())) {
+        cout << "  Error: Parallel core numbers differ from sequential ones!" << endl;
+    }
+    // A hub with three leaves and two friends in a 10-clique: peeling the leaves at level 1 drops it
+    // to degree 2, below the smallest degree left before that level's peeling
+    SocialNetwork coreCheck;
+    for (const char *name : {"Hub", "Leaf1", "Leaf2", "Leaf3"}) coreCheck.addUser(name);
+    for (int i = 0; i < 10; ++i) coreCheck.addUser("Clique" + to_string(i));
+    vector<EdgeUpdate> coreCheckEdges = {{"Hub", "Leaf1"}, {"Hub", "Leaf2"}, {"Hub", "Leaf3"}, {"Hub", "Clique0"}, {"Hub", "Clique1"}};
+    for (int i = 0; i < 10; ++i) {
+        for (int j = i + 1; j < 10; ++j) coreCheckEdges.push_back({"Clique" + to_string(i), "Clique" + to_string(j)});
+    }
+    coreCheck.applyBatch(coreCheckEdges);
+    const vector<uint32_t> sequentialCores = computeCoreNumbers(coreCheck.getSnapshot());
+    const vector<uint32_t> parallelCores = computeCoreNumbersParallel(coreCheck.getSnapshot());
+    cout << "Hub beside a 10-clique: core " << sequentialCores[0] << " (sequential), " << parallelCores[0] << " (parallel)" << endl;
+    if (sequentialCores != parallelCores) {
+        cout << "  Error: Parallel core numbers differ from sequential ones!" << endl;
+    }
+    CSRSubgraph twoCore = net.kCoreSubgraph(2);
+    cout << "2-core: " << twoCore.graph.numVertices() << " users, " << twoCore.graph.numArcs() / 2 << " friendships" << endl;
+    userToQuery = "Alice";
+    suggestions = net.suggestFriends(userToQuery, 2);
+    cout << "Friend suggestions for '" << userToQuery << "' within the 2-core:" << endl;
+    for (const auto &suggestion : suggestions) {
+        cout << "  - '" << suggestion.first << "' (via " << suggestion.second << " connection(s))" << endl;
+    }
+
+    // Test community detection with both algorithms
+    cout << "\n--- Testing: Community Detection ---" << endl;
+    const pair<CommunityMethod, const char *> methods[] = {{CommunityMethod::LabelPropagation, "Label propagation"},
+                                                           {CommunityMethod::Louvain, "Louvain"}};
+    for (const auto &method : methods) {
+        pair<double, vector<pair<string, uint32_t>>> communities = net.detectCommunities(method.first);
+        cout << method.second << " (modularity " << communities.first << "):" << endl;
+        for (const auto &entry : communities.second) {
+            cout << "  - '" << entry.first << "': community " << entry.second << endl;
+        }
+    }
+
+    // Test that reordering the snapshot leaves query results unchanged
+    cout << "\n--- Testing: Snapshot Reordering ---" << endl;
+    net.setReorderStrategy(ReorderStrategy::ReverseCuthillMcKee);
+    resultBFS = net.shortestPathBFS("Bob", "Heidi");
+    cout << "Shortest path (BFS, RCM order) from 'Bob' to 'Heidi': " << resultBFS.first << " connections" << endl;
+    suggestions = net.suggestFriends("Alice");
+    cout << "Friend suggestions for 'Alice' (RCM order):" << endl;
+    for (const auto &suggestion : suggestions) {
+        cout << "  - '" << suggestion.first << "' (via " << suggestion.second << " connection(s))" << endl;
+    }
+    net.setReorderStrategy(ReorderStrategy::None);
+
+    // Test the compressed snapshot against the plain one
+    cout << "\n--- Testing: Compressed Snapshot ---" << endl;
+    CompressedCSRGraph compressed = net.getCompressedSnapshot();
+    const CSRGraph &plain = net.getSnapshot();
+    bool listsMatch = true;
+    for (uint32_t v = 0; v < plain.numVertices(); ++v) {
+        vector<uint32_t> decoded;
+        forEachCompressedNeighbor(compressed, v, [&decoded](uint32_t u) { decoded.push_back(u); });
+        listsMatch = listsMatch && decoded == vector<uint32_t>(plain.begin(v), plain.end(v));
+    }
+    cout << "Decoded neighbor lists match: " << (listsMatch ? "yes" : "no") << endl;
+    cout << "Compressed size: " << compressed.bytesUsed() << " bytes for " << plain.numArcs() << " arcs" << endl;
+    vector<uint32_t> compressedPath = compressedShortestPath(compressed, 1, 7); // Bob -> Heidi
+    cout << "Compressed BFS from 'Bob' to 'Heidi': " << compressedPath.size() - 1 << " connections" << endl;
+    cout << "Compressed mutual friends of 'Alice' and 'David': " << compressedIntersection(compressed, 0, 3).size() << endl;
+
+    // Test the WebGraph codec: random access, sequential decoding and streaming BFS
+    cout << "\n--- Testing: WebGraph Compression ---" << endl;
+    WebGraphCompressed webGraph = net.getWebGraphSnapshot();
+    WebGraphSequentialReader webGraphReader(webGraph);
+    bool webGraphMatches = true;
+    for (uint32_t v = 0; webGraphReader.hasNext(); ++v) {
+        vector<uint32_t> randomAccess;
+        webGraphSuccessors(webGraph, v, randomAccess);
+        const vector<uint32_t> &sequential = webGraphReader.next();
+        vector<uint32_t> expected(plain.begin(v), plain.end(v));
+        webGraphMatches = webGraphMatches && randomAccess == expected && sequential == expected;
+    }
+    cout << "Decoded neighbor lists match: " << (webGraphMatches ? "yes" : "no") << endl;
+    cout << "WebGraph size: " << webGraph.bytesUsed() << " bytes for " << webGraph.arcs << " arcs" << endl;
+    cout << "WebGraph BFS distance from 'Bob' to 'Heidi': " << webGraphBFS(webGraph, 1)[7] << " connections" << endl;
+
+    // Test the hybrid neighbor container across all representations and intersection kernels
+    cout << "\n--- Testing: Hybrid Neighbor Sets ---" << endl;
+    NeighborSet tiny, medium, hub, otherHub;
+    for (uint32_t id = 0; id < 5; ++id) tiny.insert(id * 1000);       // Inline array
+    for (uint32_t id = 0; id < 3000; ++id) medium.insert(id * 3);     // Sorted vector
+    for (uint32_t id = 0; id < 100000; ++id) hub.insert(id * 2);      // Bitmap (dense chunks)
+    for (uint32_t id = 0; id < 6000; ++id) otherHub.insert(id * 37);  // Bitmap (sparse chunks)
+    const pair<const NeighborSet *, const NeighborSet *> kernelCases[] = {
+        {&tiny, &medium}, {&medium, &hub}, {&hub, &otherHub}, {&otherHub, &medium}};
+    for (const auto &kernelCase : kernelCases) {
+        vector<uint32_t> common, expected;
+        intersectNeighborSets(*kernelCase.first, *kernelCase.second, common);
+        kernelCase.first->forEach([&](uint32_t id) {
+            if (kernelCase.second->contains(id)) expected.push_back(id);
+        });
+        cout << "  |" << kernelCase.first->size() << " x " << kernelCase.second->size() << "| = " << common.size()
+             << (common == expected ? " (ok)" : " (mismatch!)") << endl;
+    }
+
+    // A batch merge (as in applyBatch) must leave the same representation as per-edge updates
+    const auto representationName = [](const NeighborSet &set) {
+        return set.isInline() ? "inline" : set.isBitmap() ? "bitmap" : "vector";
+    };
+    const tuple<uint32_t, uint32_t, uint32_t> batchCases[] = {
+        {4000, 200, 3000}, {6000, 0, 5990}, {6000, 0, 5997}, {3000, 2000, 0}}; // Initial size, additions, removals
+    for (const auto &batchCase : batchCases) {
+        const uint32_t initial = get<0>(batchCase), additions = get<1>(batchCase), removals = get<2>(batchCase);
+        NeighborSet perEdge, batched;
+        for (uint32_t id = 0; id < initial; ++id) {
+            perEdge.insert(id * 3);
+            batched.insert(id * 3);
+        }
+        vector<uint32_t> added, removed;
+        for (uint32_t id = 0; id < additions; ++id) added.push_back(id * 3 + 1);
+        for (uint32_t id = 0; id < removals; ++id) removed.push_back(id * 3);
+        for (uint32_t id : added) perEdge.insert(id);
+        for (uint32_t id : removed) perEdge.erase(id);
+        batched.reserve(batched.size() + added.size() - removed.size());
+        batched.mergeSorted(added.data(), added.data() + added.size(), removed.data(), removed.data() + removed.size());
+        batched.shrink();
+        vector<uint32_t> perEdgeIds, batchedIds;
+        perEdge.forEach([&](uint32_t id) { perEdgeIds.push_back(id); });
+        batched.forEach([&](uint32_t id) { batchedIds.push_back(id); });
+        const bool same = perEdgeIds == batchedIds && representationName(perEdge) == representationName(batched);
+        cout << "  " << initial << " +" << additions << " -" << removals << ": " << representationName(perEdge)
+             << " per edge, " << representationName(batched) << " batched" << (same ? " (ok)" : " (mismatch!)") << endl;
+    }
+
+    // Test releasing the whole graph in bulk and reloading into the same network
+    cout << "\n--- Testing: Clear and Reload ---" << endl;
+    SocialNetwork scratchNetwork;
+    scratchNetwork.addUser("Xavier");
+    scratchNetwork.addUser("Yvonne");
+    scratchNetwork.addFriendship("Xavier", "Yvonne");
+    scratchNetwork.clear();
+    scratchNetwork.getFriends("Xavier");
+    scratchNetwork.addUser("Zoe");
+    scratchNetwork.printGraph();
+
+    // Test concurrent friendship updates: every pair of members is added from worker threads, then
+    // pairs of opposite parity are removed concurrently
+    cout << "\n--- Testing: Concurrent Updates ---" << endl;
+    SocialNetwork concurrentNetwork;
+    const int members = 8;
+    for (int i = 0; i < members; ++i) concurrentNetwork.addUser("Member" + to_string(i));
+    vector<EdgeUpdate> memberPairs;
+    for (int i = 0; i < members; ++i) {
+        for (int j = i + 1; j < members; ++j) memberPairs.push_back({"Member" + to_string(i), "Member" + to_string(j)});
+    }
+    for (bool removing : {false, true}) {
+        parallelFor(memberPairs.size(), 1, [&](size_t begin, size_t end, unsigned) {
+            for (size_t p = begin; p < end; ++p) {
+                EdgeUpdate update = memberPairs[p];
+                update.kind = removing ? EdgeUpdate::Kind::Remove : EdgeUpdate::Kind::Add;
+                if (!removing || (update.user1.back() - update.user2.back()) % 2 != 0) {
+                    concurrentNetwork.updateFriendship(update);
+                }
+            }
+        });
+        cout << "After concurrent " << (removing ? "removals" : "additions") << ", Member0 has "
+             << concurrentNetwork.getFriends("Member0").size() << " friends and the network has "
+             << concurrentNetwork.getSnapshot().numArcs() / 2 << " friendships" << endl;
+    }
+    concurrentNetwork.removeFriendship("Member0", "Member2");
+    concurrentNetwork.removeFriendship("Member0", "Member1");
+    concurrentNetwork.removeFriendship("Member0", "Nobody");
+
+    // Test MVCC versions: PageRank runs on a pinned version while other threads keep updating
+    cout << "\n--- Testing: Versioned Snapshots ---" << endl;
+    concurrentNetwork.enableVersioning();
+    shared_ptr<const GraphVersion> pinned = concurrentNetwork.pinVersion();
+    vector<pair<string, double>> pinnedRanks;
+    thread analytics([&] { pinnedRanks = concurrentNetwork.pageRank(*pinned); });
+    parallelFor(memberPairs.size(), 1, [&](size_t begin, size_t end, unsigned) {
+        for (size_t p = begin; p < end; ++p) concurrentNetwork.updateFriendship(memberPairs[p]);
+    });
+    concurrentNetwork.commitVersion();
+    analytics.join();
+    shared_ptr<const GraphVersion> latest = concurrentNetwork.pinVersion();
+    for (const shared_ptr<const GraphVersion> &version : {pinned, latest}) {
+        cout << "Version " << version->number << ": " << version->numArcs / 2 << " friendships, Member0 has "
+             << concurrentNetwork.getFriends(*version, "Member0").size() << " friends" << endl;
+    }
+    cout << "PageRank on version " << pinned->number << " ranks '" << pinnedRanks[0].first << "' first ("
+         << pinnedRanks[0].second << ")" << endl;
+
+    // Test batched friendship updates with duplicates, removals and unknown users
+    cout << "\n--- Testing: Batched Updates ---" << endl;
+    scratchNetwork.addUser("Xavier");
+    scratchNetwork.addUser("Yvonne");
+    const vector<EdgeUpdate> batch = {{"Xavier", "Yvonne"},
+                                      {"Zoe", "Xavier", EdgeUpdate::Kind::Add, 2.0f},
+                                      {"Yvonne", "Xavier"},
+                                      {"Zoe", "Yvonne"},
+                                      {"Yvonne", "Zoe", EdgeUpdate::Kind::Remove},
+                                      {"Zoe", "Walter"}};
+    const char *statusNames[] = {"applied", "no change", "user not found"};
+    vector<UpdateStatus> batchStatus = scratchNetwork.applyBatch(batch);
+    for (size_t i = 0; i < batch.size(); ++i) {
+        cout << "  " << (batch[i].kind == EdgeUpdate::Kind::Add ? "add " : "remove ") << batch[i].user1 << " - "
+             << batch[i].user2 << ": " << statusNames[static_cast<int>(batchStatus[i])] << endl;
+    }
+    scratchNetwork.printGraph();
+
+    // Test time-windowed queries over friendships stamped with their creation day
+    cout << "\n--- Testing: Temporal Friendships ---" << endl;
+    SocialNetwork temporalNetwork;
+    const int64_t day = 86400;
+    for (const char *name : {"Quinn", "Riley", "Sam", "Tara", "Uma", "Vic"}) temporalNetwork.addUser(name);
+    temporalNetwork.addFriendship("Quinn", "Sam", 1.0f, 10 * day);
+    temporalNetwork.addFriendship("Riley", "Sam", 1.0f, 95 * day);
+    temporalNetwork.addFriendship("Quinn", "Tara", 1.0f, 92 * day);
+    temporalNetwork.addFriendship("Riley", "Tara", 1.0f, 93 * day);
+    temporalNetwork.addFriendship("Quinn", "Uma", 1.0f, 97 * day);
+    temporalNetwork.addFriendship("Riley", "Uma", 1.0f, 20 * day);
+    temporalNetwork.addFriendship("Uma", "Vic", 1.0f, 98 * day);
+    temporalNetwork.addFriendship("Sam", "Vic", 1.0f, 99 * day);
+    const int64_t now = 100 * day;
+    const TimeWindow lastMonth{now - 30 * day, now};
+    for (const TimeWindow &window : {TimeWindow(), lastMonth}) {
+        cout << (window.unbounded() ? "All-time" : "Last 30 days") << " mutual friends of Quinn and Riley: ";
+        for (const string &name : temporalNetwork.getMutualFriends("Quinn", "Riley", window)) cout << name << " ";
+        cout << endl;
+    }
+    cout << "Suggestions for Quinn from the last 30 days:" << endl;
+    for (const auto &suggestion : temporalNetwork.suggestFriends("Quinn", 0, lastMonth)) {
+        cout << "  " << suggestion.first << " (" << suggestion.second << " recent mutual friends)" << endl;
+    }
+    resultBFS = temporalNetwork.shortestPathBFS("Quinn", "Vic");
+    cout << "All-time distance from Quinn to Vic: " << resultBFS.first << endl;
+    resultBFS = temporalNetwork.shortestPathBFS("Quinn", "Riley", {now - 3 * day, now});
+    cout << "Distance from Quinn to Riley over the last 3 days: "
+         << (resultBFS.first == -1 ? "no path" : to_string(resultBFS.first)) << endl;
+
+    // Test attribute columns and filtered queries on the same users
+    cout << "\n--- Testing: User Attributes ---" << endl;
+    temporalNetwork.defineAttribute("region", AttributeType::String);
+    temporalNetwork.defineAttribute("age", AttributeType::Int);
+    temporalNetwork.defineAttribute("private", AttributeType::Flag);
+    const vector<tuple<string, string, int>> profiles = {
+        {"Quinn", "EU", 31}, {"Riley", "EU", 28}, {"Sam", "US", 45}, {"Tara", "EU", 35}, {"Uma", "EU", 22}, {"Vic", "US", 0}};
+    for (const auto &profile : profiles) {
+        temporalNetwork.setAttribute(get<0>(profile), "region", get<1>(profile));
+        if (get<2>(profile) > 0) temporalNetwork.setAttribute(get<0>(profile), "age", get<2>(profile));
+    }
+    temporalNetwork.setFlag("Uma", "private", true);
+    temporalNetwork.setAttribute("Uma", "private", "yes");
+
+    const UserFilter inEurope = UserFilter::equals("region", "EU");
+    const UserFilter visible = ~UserFilter::isSet("private");
+    cout << "Quinn's friends in the EU: ";
+    for (const string &name : temporalNetwork.getFriends("Quinn", inEurope)) cout << name << " ";
+    cout << endl;
+    cout << "Suggestions for Quinn aged 25-40 with public profiles:" << endl;
+    for (const auto &suggestion : temporalNetwork.suggestFriends("Quinn", 0, TimeWindow(), UserFilter::between("age", 25, 40) & visible)) {
+        cout << "  " << suggestion.first << " (" << suggestion.second << " mutual friends)" << endl;
+    }
+    resultBFS = temporalNetwork.shortestPathBFS("Quinn", "Vic", TimeWindow(), inEurope);
+    cout << "Path from Quinn to Vic through EU users: ";
+    for (const string &name : resultBFS.second) cout << name << " ";
+    cout << "(distance " << resultBFS.first << ")" << endl;
+    resultBFS = temporalNetwork.shortestPathBFS("Quinn", "Vic", TimeWindow(), inEurope & visible);
+    temporalNetwork.getFriends("Quinn", UserFilter::equals("city", "Paris"));
+
+    // Test batched name resolution through the hash index
+    cout << "\n--- Testing: Name Lookup ---" << endl;
+    const vector<string_view> lookupNames = {"Quinn", "Vic", "Walter"};
+    vector<uint32_t> lookedUp = temporalNetwork.lookupIds(lookupNames);
+    for (size_t i = 0; i < lookupNames.size(); ++i) {
+        cout << lookupNames[i] << ": "
+             << (lookedUp[i] == NameIndex::kMissing ? "not found" : "user ID " + to_string(lookedUp[i])) << endl;
+    }
+
+    // Test ego-network extraction, with and without a node budget
+    cout << "\n--- Testing: Ego Network ---" << endl;
+    for (size_t budget : {size_t(100), size_t(4)}) {
+        EgoNetwork ego = net.egoNetwork("Alice", 2, budget);
+        cout << "Alice's 2-hop network (at most " << budget << " users): " << ego.names.size() << " users, "
+             << ego.graph.numArcs() / 2 << " friendships" << endl;
+        for (uint32_t local = 0; local < ego.names.size(); ++local) {
+            cout << "  " << local << " " << ego.names[local] << " (hop " << ego.hops[local] << "):";
+            for (const uint32_t *u = ego.graph.begin(local); u != ego.graph.end(local); ++u) cout << " " << *u;
+            cout << endl;
+        }
+    }
+
+    // Test prefix and fuzzy name search, ranked by degree and by distance from a user
+    cout << "\n--- Testing: User Search ---" << endl;
+    auto printHits = [](const string &title, const vector<UserSearchHit> &hits) {
+        cout << title << ":" << endl;
+        for (const UserSearchHit &hit : hits) {
+            cout << "  " << hit.name << " (degree " << hit.degree;
+            if (hit.distance >= 0) cout << ", distance " << hit.distance;
+            if (hit.edits > 0) cout << ", edit distance " << hit.edits;
+            cout << ")" << endl;
+        }
+    };
+    for (const char *name : {"Alicia", "Alina", "Frankie"}) net.addUser(name);
+    net.addFriendship("Alicia", "Frankie");
+    printHits("Names starting with 'Al' by degree", net.searchUsers("Al", 3));
+    printHits("Names starting with 'Al' near Frankie", net.searchUsers("Al", 3, SearchRanking::Distance, "Frankie"));
+    printHits("Names within 1 edit of 'Frnk'", net.fuzzySearchUsers("Frnk", 1, 5));
+    printHits("Names within 2 edits of 'Alise'", net.fuzzySearchUsers("Alise", 2, 5, SearchRanking::Distance, "Frankie"));
+
+    // Test link-prediction scorers selected at compile time
+    cout << "\n--- Testing: Similarity Suggestions ---" << endl;
+    auto printSimilar = [&](auto scorer, const char *label) {
+        cout << label << " suggestions for 'Alice':";
+        for (const auto &suggestion : net.suggestFriendsBy<decltype(scorer)>("Alice", 3)) {
+            cout << " '" << suggestion.first << "' (" << suggestion.second << ")";
+        }
+        cout << endl;
+    };
+    printSimilar(MutualFriendsScore(), "Common neighbors");
+    printSimilar(JaccardScore(), "Jaccard");
+    printSimilar(CosineScore(), "Cosine");
+    printSimilar(AdamicAdarScore(), "Adamic-Adar");
+    printSimilar(ResourceAllocationScore(), "Resource allocation");
+    net.suggestFriendsBy<JaccardScore>("Nobody", 3);
+
+    // Test MinHash similarity estimates, kept current as friendships change
+    cout << "\n--- Testing: Approximate Similarity (MinHash) ---" << endl;
+    auto printSimilarUsers = [&](const string &user) {
+        cout << "Users similar to '" << user << "':";
+        for (const auto &entry : net.similarUsers(user, 3)) cout << " '" << entry.first << "' (" << entry.second << ")";
+        cout << endl;
+    };
+    cout << "Estimated similarity of 'Alice' and 'David': " << net.estimateSimilarity("Alice", "David") << endl;
+    printSimilarUsers("Alice");
+    net.addFriendship("Alice", "Eve");
+    cout << "Estimated similarity of 'Alice' and 'David': " << net.estimateSimilarity("Alice", "David") << endl;
+    printSimilarUsers("Alice");
+    net.removeFriendship("Alice", "Eve");
+    cout << "Estimated similarity of 'Alice' and 'David': " << net.estimateSimilarity("Alice", "David") << endl;
+    net.estimateSimilarity("Alice", "Nobody");
+
+    // Test friendship checks through the Bloom filter, which never changes the answers
+    cout << "\n--- Testing: Friendship Filter ---" << endl;
+    net.enableFriendshipFilter(2.0);
+    net.enableFriendshipFilter(0.01);
+    for (const auto &pair : {make_pair("Alice", "Bob"), make_pair("Alice", "David"), make_pair("Frank", "Heidi")}) {
+        cout << "'" << pair.first << "' and '" << pair.second << "' are "
+             << (net.areFriends(pair.first, pair.second) ? "friends" : "not friends") << endl;
+    }
+    net.addFriendship("Alice", "David");
+    cout << "'Alice' and 'David' are " << (net.areFriends("Alice", "David") ? "friends" : "not friends") << endl;
+    net.removeFriendship("Alice", "David");
+    cout << "'Alice' and 'David' are " << (net.areFriends("Alice", "David") ? "friends" : "not friends") << endl;
+    net.areFriends("Alice", "Nobody");
+
+    // Test alternative introduction chains (k shortest loopless paths)
+    cout << "\n--- Testing: k Shortest Paths ---" << endl;
+    vector<list<string>> chains = net.kShortestPaths("Alice", "Frank", 5);
+    cout << chains.size() << " paths from 'Alice' to 'Frank':" << endl;
+    for (const list<string> &chain : chains) {
+        cout << "  " << chain.size() - 1 << " hops: ";
+        separator = "";
+        for (const string &node : chain) {
+            cout << separator << "'" << node << "'";
+            separator = " -> ";
+        }
+        cout << endl;
+    }
+    net.kShortestPaths("Grace", "Alice", 3);
+    net.kShortestPaths("Alice", "Nobody", 3);
+
+    // Test counting shortest paths ("connected through N paths of length d") with sampled paths
+    cout << "\n--- Testing: Shortest Path Counts ---" << endl;
+    for (const auto &pair : {make_pair("Alice", "David"), make_pair("Bob", "Heidi"), make_pair("Alice", "Alice")}) {
+        ShortestPathCount connection = net.countShortestPaths(pair.first, pair.second, 2);
+        cout << "'" << pair.first << "' and '" << pair.second << "' are connected through " << connection.countString()
+             << " shortest path(s) of length " << connection.distance << endl;
+        for (const list<string> &sample : connection.samples) {
+            cout << "  ";
+            separator = "";
+            for (const string &node : sample) {
+                cout << separator << "'" << node << "'";
+                separator = " -> ";
+            }
+            cout << endl;
+        }
+    }
+    cout << "'Grace' and 'Alice': " << net.countShortestPaths("Grace", "Alice").countString() << " paths" << endl;
+    net.countShortestPaths("Nobody", "Alice");
+
     cout << "\n--- Testing Complete ---" << endl;
     return 0;
 }
\ No newline at end of file